@@ -1,34 +1,442 @@
 #include "gff_entry.hpp"
+#include "gff_view.hpp"
+#include "gff_stream.hpp"
+#include "gff_index.hpp"
+#include "gff_cache.hpp"
+#include "gff_parallel.hpp"
+#include "gff_table.hpp"
+#include "gff_writer.hpp"
+#include "gff_bgzf.hpp"
+#include "gff_attr.hpp"
+#include "gff_hierarchy.hpp"
+#include "gff_join.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
 
 using namespace std;
+
+// Prints command line help
+static void usage(const char* prog)
+{
+    std::cerr << "\nusage: " << prog << " [--mmap | --stream | --overlap | --cache | --models] [--threads=N] [--where=<pred>]... <input_file> <seq_id> <start> <stop>\n"
+              << "       " << prog << " --where=<pred> [--where=<pred>]... <input_file>\n"
+              << "       " << prog << " --batch=<query_file> [--where=<pred>]... [--overlap] [--models] [--cache] [--threads=N] <input_file>\n"
+              << "       " << prog << " --join=<pairs|nearest|coverage> [--mem=MB] <a.gff3> <b.gff3>\n"
+              << "       " << prog << " --bench [--threads=N] <input_file>\n"
+              << "  --mmap            memory-map the input and only build entries for matching records\n"
+              << "  --stream          filter while reading through a fixed-size buffer (constant memory)\n"
+              << "  --batch=<file>    index the input once, then answer every \"<seq_id> <start> <stop>\" line of file\n"
+              << "  --overlap         report features overlapping the range instead of lying inside it (uses the index)\n"
+              << "  --models          report the whole gene models (ID/Parent trees) of the matching features (uses the index)\n"
+              << "  --cache           answer index queries from <input_file>.gffbin, (re)building it when missing or stale\n"
+              << "  --where=<pred>    only report features whose attributes match: key=value, key=v1|v2|v3 or key~text\n"
+              << "                    (a comma-separated value matches any of its items; repeat to require several)\n"
+              << "  --join=<mode>     sweep-line join of a.gff3 against b.gff3: overlapping pairs, nearest b feature, or\n"
+              << "                    coverage of each a feature by b; unsorted inputs are sorted first\n"
+              << "  --mem=MB          memory budget for sorting a join input; larger inputs are sorted on disk (default 1024)\n"
+              << "  --threads=N       parse the whole file on N threads (0 = all hardware threads)\n"
+              << "  input_file may be gzip or BGZF compressed; a BGZF file with a .tbi or .csi index is queried through it\n"
+              << "  --bench           time the readers on input_file (the parallel one for 1, 2, 4 ... N threads) and the tokenizers\n"
+              << std::endl;
+}
+
+// Parses the whole input: readGFF() by default, the parallel reader when a thread count is given;
+// false if a compressed input cannot be inflated
+static bool loadGFF(const char* filename, int threads, vector<GFFEntry>& data)
+{
+    if (isGzipFile(filename))
+        return readGFFCompressed(filename, threads < 0 ? 1 : static_cast<unsigned>(threads), data);
+    if (threads < 0)
+        data = readGFF(filename);
+    else
+        data = readGFFParallel(filename, static_cast<unsigned>(threads));
+    return true;
+}
+
+// Times each reader on one file and prints records, seconds, MB/s and speedup over one thread
+static void benchReaders(const char* filename, unsigned maxThreads)
+{
+    struct stat st;
+    double mb = stat(filename, &st) == 0 ? static_cast<double>(st.st_size) / 1e6 : 0;
+    double base = 0;
+    auto timeReader = [&](const string& name, auto&& load)
+    {
+        auto t0 = chrono::steady_clock::now();
+        vector<GFFEntry> entries = load();
+        double sec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+        if (base == 0)
+            base = sec;
+        cout << left << setw(22) << name << right << setw(12) << entries.size() << setw(10) << fixed << setprecision(3) << sec
+             << setw(10) << setprecision(1) << mb / sec << " MB/s" << setw(8) << setprecision(2) << base / sec << "x" << endl;
+    };
+
+    cout << left << setw(22) << "reader" << right << setw(12) << "records" << setw(10) << "seconds" << setw(15) << "throughput" << setw(9) << "speedup" << endl;
+    timeReader("readGFF", [&] { return readGFF(filename); });
+    {
+        auto t0 = chrono::steady_clock::now();
+        GFFTable table = readGFFTable(filename);
+        double sec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+        cout << left << setw(22) << "readGFFTable" << right << setw(12) << table.size() << setw(10) << fixed << setprecision(3) << sec
+             << setw(10) << setprecision(1) << mb / sec << " MB/s" << setw(8) << setprecision(2) << base / sec << "x" << endl;
+    }
+    base = 0;	// parallel speedups are relative to the 1-thread parallel run
+    for (unsigned t = 1;; t = min(t * 2, maxThreads))
+    {
+        timeReader("readGFFParallel x" + to_string(t), [&] { return readGFFParallel(filename, t); });
+        if (t == maxThreads)
+            break;
+    }
+}
+
+// Times the tokenizers alone on a mapped file (no GFFEntry is built) and prints bytes per second
+static void benchTokenizer(const char* filename)
+{
+    MappedFile file(filename);
+    string_view data = file.view();
+    double mb = static_cast<double>(data.size()) / 1e6;
+    auto timeIt = [&](const string& name, auto&& run)
+    {
+        auto t0 = chrono::steady_clock::now();
+        uint64_t check = run();
+        double sec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+        cout << left << setw(22) << name << right << setw(12) << check << setw(10) << fixed << setprecision(3) << sec
+             << setw(10) << setprecision(1) << mb / sec << " MB/s" << endl;
+    };
+
+    cout << endl << left << setw(22) << "tokenizer" << right << setw(12) << "checksum" << setw(10) << "seconds" << setw(15) << "throughput" << endl;
+    // Current path: getline + istringstream per column, as in readGFF()
+    timeIt("istringstream", [&]
+    {
+        uint64_t sum = 0;
+        istringstream in{string(data)};
+        string line, d;
+        while (getline(in, line))
+        {
+            if (line.find("#") == 0)
+                continue;
+            istringstream row(line);
+            for (int c = 0; c < 9 && getline(row, d, c < 8 ? '\t' : '\n'); ++c)
+                if (c == 3)
+                    sum += strtoull(d.c_str(), nullptr, 0);
+        }
+        return sum;
+    });
+    timeIt("memchr lines", [&]
+    {
+        uint64_t sum = 0;
+        GFFView v;
+        for (string_view rest = data; !rest.empty();)
+        {
+            size_t nl = rest.find('\n');
+            if (parseGFFLine(rest.substr(0, nl), v))
+                sum += v.start;
+            rest.remove_prefix(nl == string_view::npos ? rest.size() : nl + 1);
+        }
+        return sum;
+    });
+    for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::SSE42, SimdLevel::AVX2})
+    {
+        if (level > detectSimd())
+            continue;
+        timeIt(string("delims ") + simdLevelName(level), [&]
+        {
+            vector<uint32_t> pos(DelimCursor::BLOCK);
+            uint64_t count = 0;
+            DelimScanFn scan = delimScanner(level);
+            for (size_t i = 0; i < data.size(); i += DelimCursor::BLOCK)
+                count += scan(data.data() + i, min(data.size() - i, size_t(DelimCursor::BLOCK)), pos.data());
+            return count;
+        });
+        timeIt(string("scanGFF ") + simdLevelName(level), [&]
+        {
+            uint64_t sum = 0;
+            scanGFF(data, [&sum](const GFFView& v) { sum += v.start; }, level);
+            return sum;
+        });
+    }
+}
+
 // This program reads a GFF3 file, parses all values and objects for each line and outputs queried seq_id in given range from start to end.
 int main(int argc, const char* argv[])
 {
-    // Initializing variables
-    vector<GFFEntry> data;
-    string seqid = argv[2], a;
-    int start = stoi(argv[3]);
-    int end = stoi(argv[4]);
+    // Leading --options select the reader mode
+    bool useMmap = false, useStream = false, overlap = false, useCache = false, bench = false, models = false;
+    int threads = -1;
+    string batchFile, joinMode;
+    size_t joinMemory = size_t(1024) << 20;
+    AttrFilter filter;
+    int arg = 1;
+    for (; arg < argc && strncmp(argv[arg], "--", 2) == 0; ++arg)
+    {
+        string opt = argv[arg];
+        if (opt == "--mmap")
+            useMmap = true;
+        else if (opt == "--stream")
+            useStream = true;
+        else if (opt == "--overlap")
+            overlap = true;
+        else if (opt == "--cache")
+            useCache = true;
+        else if (opt == "--models")
+            models = true;
+        else if (opt == "--bench")
+            bench = true;
+        else if (opt.compare(0, 10, "--threads=") == 0)
+            threads = stoi(opt.substr(10));
+        else if (opt.compare(0, 8, "--batch=") == 0)
+            batchFile = opt.substr(8);
+        else if (opt.compare(0, 7, "--join=") == 0)
+            joinMode = opt.substr(7);
+        else if (opt.compare(0, 6, "--mem=") == 0)
+            joinMemory = static_cast<size_t>(stoull(opt.substr(6))) << 20;
+        else if (opt.compare(0, 8, "--where=") == 0)
+        {
+            AttrPredicate p;
+            if (!parseAttrPredicate(opt.substr(8), p))
+            {
+                std::cerr << "invalid attribute predicate: " << opt.substr(8) << std::endl;
+                return 1;
+            }
+            filter.add(p);
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
     // only when given right input, processes input file
-    if (argc == 5)
+    int positional = argc - arg;
+    bool whereOnly = !filter.empty() && batchFile.empty() && !bench && positional == 1;
+    if (positional != (!joinMode.empty() ? 2 : batchFile.empty() && !bench && !whereOnly ? 4 : 1)
+        || (!joinMode.empty() && joinMode != "pairs" && joinMode != "nearest" && joinMode != "coverage"))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (bench)
+    {
+        benchReaders(argv[arg], threadCount(threads < 0 ? 0 : static_cast<unsigned>(threads)));
+        benchTokenizer(argv[arg]);
+        return 0;
+    }
+
+    // Join mode: both files are streamed in (seqid, start) order through one sweep
+    if (!joinMode.empty())
     {
-        ifstream infile;
-        infile.open(argv[1]);
-        // Error check
-        if (!infile  || seqid.empty() || (start == 0 && end == 0))
+        SortedGFF a, b;
+        for (int i = 0; i < 2; ++i)
+            if (!(i == 0 ? a : b).open(argv[arg + i], joinMemory))
+            {
+                std::cerr << "cannot read or sort input file: " << argv[arg + i] << std::endl;
+                return 1;
+            }
+        JoinMode mode = joinMode == "pairs" ? JoinMode::Pairs : joinMode == "nearest" ? JoinMode::Nearest : JoinMode::Coverage;
+        GFFWriter out(STDOUT_FILENO);
+        joinGFF(a, b, mode, [&out](const string& line) { out.text(line); });
+        return 0;
+    }
+
+    // Attribute query over the whole file: predicates are tested on the raw attribute column
+    if (whereOnly)
+    {
+        GFFWriter out(STDOUT_FILENO);
+        auto writeView = [&out](const GFFView& v) { out.write(v); };
+        bool read;
+        if (isGzipFile(argv[arg]))
+            read = inflateGFFLines(argv[arg], threads < 0 ? 1 : static_cast<unsigned>(threads), [&](string_view text)
+            {
+                scanGFFWhere(text, filter, writeView);
+            });
+        else
+        {
+            MappedFile file(argv[arg]);
+            read = file.is_open();
+            scanGFFWhere(file.view(), filter, writeView);
+        }
+        if (!read)
+        {
+            std::cerr << "cannot open input file: " << argv[arg] << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // Index mode: parse once, answer every query from the interval index
+    if (!batchFile.empty() || overlap || useCache || models)
+    {
+        vector<GFFQuery> queries;
+        if (!batchFile.empty())
+        {
+            ifstream qfile(batchFile);
+            if (!qfile)
+            {
+                std::cerr << "cannot open query file: " << batchFile << std::endl;
+                return 1;
+            }
+            queries = readQueries(batchFile);
+        }
+        else
+            queries.push_back(GFFQuery{argv[arg + 1], stoull(argv[arg + 2]), stoull(argv[arg + 3])});
+
+        ifstream infile(argv[arg]);
+        if (!infile)
         {
-            std::cerr << "cannot open input file: " << argv[1] << std::endl;
+            std::cerr << "cannot open input file: " << argv[arg] << std::endl;
             return 1;
         }
-    } else
+        infile.close();
+
+        // A valid cache is mapped and used as is; otherwise the text file is read into a
+        // columnar table and indexed (and the cache written)
+        GFFCache cache;
+        bool cached = useCache && cache.open(argv[arg]);
+        GFFTable table;
+        GFFIndex index;
+        if (!cached)
+        {
+            unsigned n = threads < 0 ? 1 : static_cast<unsigned>(threads);
+            bool read = true;
+            if (isGzipFile(argv[arg]))
+                read = readGFFTableCompressed(argv[arg], n, table);
+            else
+                table = readGFFTable(argv[arg], n);
+            if (!read)
+            {
+                std::cerr << "cannot decompress input file: " << argv[arg] << std::endl;
+                return 1;
+            }
+            index.build(table.size(), [&table](size_t r)
+            {
+                return IntervalKey{table.seqid(r), table.start(r), table.end(r)};
+            });
+            if (useCache && !writeGFFCache(argv[arg], table, index))
+                std::cerr << "cannot write cache file: " << cacheFileName(argv[arg]) << std::endl;
+        }
+        // The first predicate is answered from an inverted index of its key, the others per hit
+        AttrIndex attrIndex;
+        vector<uint32_t> candidates;
+        if (!cached && !filter.empty())
+        {
+            attrIndex.build(table, filter.predicates()[0].key);
+            candidates = attrIndex.lookup(filter.predicates()[0]);
+        }
+        // Hits are expanded to every record of the ID/Parent trees they belong to
+        GFFHierarchy hierarchy;
+        if (models && cached)
+        {
+            auto attr = [&cache](size_t r, string_view key)
+            {
+                string_view v;
+                return findAttribute(cache.view(r).attributes, key, v) ? v : string_view();
+            };
+            hierarchy.build(cache.size(), [&](size_t r) { return attr(r, "ID"); }, [&](size_t r) { return attr(r, "Parent"); });
+        }
+        else if (models)
+            hierarchy.build(table);
+        GFFWriter out(STDOUT_FILENO);
+        for (const auto& q : queries)
         {
-        std::cerr << "\nusage: " << argv[0] << "  <input_file> <seq_id> <start> <stop>\n"
-                  << std::endl;
+            // Each batch answer is introduced by a comment line naming its query
+            if (!batchFile.empty())
+                out.text("# " + q.seqid + ' ' + to_string(q.start) + ' ' + to_string(q.end) + '\n');
+            if (cached)
+            {
+                vector<uint32_t> hits = overlap ? cache.overlapping(q.seqid, q.start, q.end) : cache.contained(q.seqid, q.start, q.end);
+                if (!filter.empty())
+                    hits.erase(remove_if(hits.begin(), hits.end(), [&](uint32_t r) { return !filter.matches(cache.view(r).attributes); }), hits.end());
+                if (models)
+                    hits = hierarchy.models(hits);
+                for (uint32_t r : hits)
+                    out.write(cache.view(r));
+            }
+            else
+            {
+                vector<uint32_t> hits = overlap ? index.overlapping(q.seqid, q.start, q.end) : index.contained(q.seqid, q.start, q.end);
+                if (!filter.empty())
+                {
+                    vector<uint32_t> both;
+                    set_intersection(hits.begin(), hits.end(), candidates.begin(), candidates.end(), back_inserter(both));
+                    both.erase(remove_if(both.begin(), both.end(), [&](uint32_t r) { return !filter.matches(table, r); }), both.end());
+                    hits.swap(both);
+                }
+                if (models)
+                    hits = hierarchy.models(hits);
+                for (uint32_t r : hits)
+                    out.write(table, r);
+            }
+        }
+        return 0;
+    }
+
+    // Initializing variables
+    vector<GFFEntry> data;
+    const char* filename = argv[arg];
+    string seqid = argv[arg + 1];
+    int start = stoi(argv[arg + 2]);
+    int end = stoi(argv[arg + 3]);
+
+    ifstream infile;
+    infile.open(filename);
+    // Error check
+    if (!infile  || seqid.empty() || (start == 0 && end == 0))
+    {
+        std::cerr << "cannot open input file: " << filename << std::endl;
         return 1;
     }
-    data = readGFF(argv[1]);
-    // Processes the output of readGFF and couts respectively.
-    writeGFF(data, cout, seqid, start, end);
+    infile.close();
+
+    GFFRegion region{seqid, static_cast<uint64_t>(start), static_cast<uint64_t>(end)};
+    // Matching views are formatted straight into the output buffer, attributes in file order
+    GFFWriter out(STDOUT_FILENO);
+    auto writeMatch = [&out, &filter](const GFFView& v)
+    {
+        if (filter.matches(v.attributes))
+            out.write(v);
+    };
+    if (isGzipFile(filename))
+    {
+        // Compressed input: index lookup or parallel inflate for every mode
+        if (!scanCompressedRegion(filename, region, threads < 0 ? 1 : static_cast<unsigned>(threads), writeMatch))
+        {
+            std::cerr << "cannot decompress input file: " << filename << std::endl;
+            return 1;
+        }
+    }
+    else if (useStream)
+    {
+        ifstream in(filename, ios::binary);
+        streamGFF(in, region, writeMatch);
+    }
+    else if (useMmap)
+    {
+        MappedFile file(filename);
+        if (!file.is_open())
+        {
+            std::cerr << "cannot map input file: " << filename << std::endl;
+            return 1;
+        }
+        scanGFFRegion(file.view(), region, writeMatch);
+    }
+    else
+    {
+        // With predicates, entries are only built for the records that pass them
+        bool read = true;
+        if (filter.empty())
+            read = loadGFF(filename, threads, data);
+        else
+            data = readGFFWhere(filename, filter);
+        if (!read)
+        {
+            std::cerr << "cannot decompress input file: " << filename << std::endl;
+            return 1;
+        }
+        // Processes the output of readGFF and writes it out respectively.
+        writeGFF(data, out, seqid, static_cast<uint64_t>(start), static_cast<uint64_t>(end));
+    }
 
     return 0;
 }
@@ -5,11 +5,29 @@
 //  Also, in models where vertex names are not represented with integers, the use of a symbol table could be used to provide a 1-to-1 mapping to associate V arbitrary names with V integers in the proper range.
 
 #include<iostream>
+#include<iomanip>
 #include<vector>
-#include<list>
-#include<map>
+#include<algorithm>
+#include<queue>
+#include<string>
+#include<chrono>
 #include<ctime>
 #include<cstdlib>
+#include<functional>
+#include<cmath>
+#include<memory>
+#include<sstream>
+
+#include "graph_heap.hpp"
+#include "graph_csr.hpp"
+#include "graph_symbols.hpp"
+#include "graph_apsp.hpp"
+#include "graph_search.hpp"
+#include "graph_ch.hpp"
+#include "graph_random.hpp"
+#include "graph_delta.hpp"
+#include "graph_dynamic.hpp"
+#include "graph_stats.hpp"
 
 
 using namespace std;
@@ -18,15 +36,6 @@ using namespace std;
 // To represent no edge/path between two nodes
 const int INFINIT=999999;
 
-// To print list<char> variables
-ostream &operator<<(ostream &output, list<char> L)
-{
-    list<char>::iterator i;
-    for(i=L.begin(); i != L.end(); ++i)
-        output << *i << " ";
-    return output;
-}
-
 // Converts node numbers into chars
 inline char vertIntToChar(int n)
 {
@@ -36,41 +45,53 @@ inline char vertIntToChar(int n)
         return static_cast<char>('a'+n-26);
 }
 
+// Default node name: A..Za..z for the first 52 nodes, the node number for the others
+inline string vertIntToLabel(int n)
+{
+    if (n<52)
+        return string(1, vertIntToChar(n));
+    return to_string(n);
+}
+
 
-// Node: To store information about nodes/edges in the adjacency list of a graph
-// Adjacency lists is a list of Nodes (identified by numbers from 0 to 51)
-// Each node contains a list of neighbors containing edge weight
+// Node: To store information about edges in the adjacency list of a graph
+// Nodes are identified by numbers from 0 to V-1; adjacency list x holds the neighbors of node x
+// with the edge weight
 typedef struct strNode Node;
 struct strNode
 {
     int number;
     int weight;
-    list<Node> edges;
 };
 
 // Graph Class : To represent a Graph through an adjacency list
+// Nodes are numbers; names are optional and kept in a SymbolTable (see graph_symbols.hpp)
 class Graph
 {
 public:
     Graph();
     Graph(int numVertices, int initialValue);
-    char get_node_value(int x);
-    void set_node_value(char x, char name);
-    int get_edge_value(char x, char y);
-    void set_edge_value(char x, char y, int value);
-    bool adjacent(char x, char y);
-    list<char> neighbors(char x);
+    Graph(int numVertices, const vector<WeightedEdge>& edges);
+    string get_node_value(int x);
+    void set_node_value(int x, const string& name);
+    int get_node_number(const string& name);
+    int get_edge_value(int x, int y);
+    void set_edge_value(int x, int y, int value);
+    bool adjacent(int x, int y);
+    vector<int> neighbors(int x);
     int V();
     int E();
-    list<char> vertices();
+    vector<int> vertices();
+    CSRGraph csr();
     void show();
 
 private:
+    vector<Node>& edgesOf(int x) { return adjList[static_cast<size_t>(x)]; }	// Adjacency list of node number x
+
     int numV;			// Number of nodes
     int numE;			// Number of edges
-    vector<char> nodeNames;	// To map node numbers into node names
-    map<char, int> nodeNumbers;	// To map node names into node numbers
-    list<Node> adjList;		// To represent the Graph
+    SymbolTable names;		// Node names given by set_node_value()
+    vector<vector<Node> > adjList;	// To represent the Graph (indexed by node number)
 };
 
 // Creates an empty graph
@@ -85,148 +106,106 @@ Graph::Graph()
 // Creates adjacency list with all nodes and empty edge list
 Graph::Graph(int numVertices, int initialValue=INFINIT)
 {
-    // Create nodes and link it to default names (0..51 -> A..Za..z)
     numV = numVertices;
     numE = 0;
-    nodeNames.resize(numVertices);
-    for (int x=0; x<numV; ++x)
-    {
-        nodeNames[x] = vertIntToChar(x);
-        nodeNumbers[vertIntToChar(x)]=x;
-    }
+    adjList.assign(static_cast<size_t>(numVertices), vector<Node>());
+}
 
-    adjList.clear();
-    for(int i=0; i<numVertices; ++i)
+// Creates a graph from a list of distinct edges without self loops (as gnpEdges() returns them);
+// each edge is appended to both adjacency lists without searching them
+Graph::Graph(int numVertices, const vector<WeightedEdge>& edges)
+{
+    numV = numVertices;
+    numE = static_cast<int>(edges.size());
+    adjList.assign(static_cast<size_t>(numVertices), vector<Node>());
+    for (vector<WeightedEdge>::const_iterator e=edges.begin(); e != edges.end(); ++e)
     {
-        Node newNode;
-        newNode.number = i;
-        newNode.weight = 0;
-        newNode.edges.clear();
-        adjList.push_back(newNode);
+        Node nodeTo = {static_cast<int>((*e).to), (*e).weight};
+        Node nodeFrom = {static_cast<int>((*e).from), (*e).weight};
+        adjList[(*e).from].push_back(nodeTo);
+        adjList[(*e).to].push_back(nodeFrom);
     }
 }
 
-// Returns node name linked to node number x
-char Graph::get_node_value(int x)
+// Returns node name linked to node number x (its default name if none was set)
+string Graph::get_node_value(int x)
+{
+    const string& name = names.name(x);
+    return name.empty() ? vertIntToLabel(x) : name;
+}
+
+// Changes the name of node number x
+void Graph::set_node_value(int x, const string& name)
 {
-    return nodeNames[x];
+    names.assign(x, name);
 }
 
-// Changes node name (from 'x' to 'name')
-void Graph::set_node_value(char x, char name)
+// Returns node number linked to a name given by set_node_value() (-1 if there is none)
+int Graph::get_node_number(const string& name)
 {
-    int posX = nodeNumbers[x];	// Get the number of node 'x'
-    nodeNames[posX] = name;	// Link node number to 'name'
-    nodeNumbers[name]=posX;	// Link 'name' to node number
+    return names.find(name);
 }
 
 // Returns edge weight between 'x' and 'y'
 // Returns const int if edge doesn't exist
-int Graph::get_edge_value(char x, char y)
+int Graph::get_edge_value(int x, int y)
 {
-    for(list<Node>::iterator i=adjList.begin(); i != adjList.end(); ++i)
-    {
-        if ((*i).number==nodeNumbers[x])
-            for(list<Node>::iterator j=(*i).edges.begin(); j != (*i).edges.end(); ++j)
-            {
-                if ((*j).number==nodeNumbers[y])
-                    return (*j).weight;
-            }
-    }
+    for(vector<Node>::iterator j=edgesOf(x).begin(); j != edgesOf(x).end(); ++j)
+        if ((*j).number==y)
+            return (*j).weight;
     return INFINIT;
 }
 
 // Sets edge weight between 'x' and 'y'
-void Graph::set_edge_value(char x, char y, int value)
+void Graph::set_edge_value(int x, int y, int value)
 {
-    bool found;
     // Add 'y' in the list of 'x' neighbors (if doesn't exist)
     // Set edge weight to value
-    for(list<Node>::iterator i=adjList.begin(); i != adjList.end(); ++i)
-    {
-        if ((*i).number==nodeNumbers[x])
+    bool found = false;
+    for(vector<Node>::iterator j=edgesOf(x).begin(); j != edgesOf(x).end(); ++j)
+        if ((*j).number==y)
         {
-            found = false;
-            for(list<Node>::iterator j=(*i).edges.begin(); j != (*i).edges.end(); ++j)
-            {
-                if ((*j).number==nodeNumbers[y])
-                {
-                    (*j).weight=value;
-                    found = true;
-                }
-            }
-            if (!found)
-            {
-                Node newNodeY;
-                newNodeY.number = nodeNumbers[y];
-                newNodeY.weight = value;
-                newNodeY.edges.clear();
-                (*i).edges.push_back(newNodeY);
-            }
+            (*j).weight=value;
+            found = true;
         }
+    if (!found)
+    {
+        Node newNodeY = {y, value};
+        edgesOf(x).push_back(newNodeY);
     }
 
     // Adds 'x' in the list of 'y' neighbors (if doesn't exist)
     // Sets edge weight to value
-    for(list<Node>::iterator i=adjList.begin(); i != adjList.end(); ++i)
-    {
-        if ((*i).number==nodeNumbers[y])
+    found = false;
+    for(vector<Node>::iterator j=edgesOf(y).begin(); j != edgesOf(y).end(); ++j)
+        if ((*j).number==x)
         {
-            found = false;
-            for(list<Node>::iterator j=(*i).edges.begin(); j != (*i).edges.end(); ++j)
-            {
-                if ((*j).number==nodeNumbers[x])
-                {
-                    (*j).weight=value;
-                    found = true;
-                }
-            }
-            if (!found)
-            {
-                Node newNodeX;
-                newNodeX.number = nodeNumbers[x];
-                newNodeX.weight = value;
-                newNodeX.edges.clear();
-                (*i).edges.push_back(newNodeX);
-                ++numE;	  	// Increment the number of edges in the graph
-            }
+            (*j).weight=value;
+            found = true;
         }
+    if (!found)
+    {
+        Node newNodeX = {x, value};
+        edgesOf(y).push_back(newNodeX);
+        ++numE;	  	// Increment the number of edges in the graph
     }
 }
 
 // Returns true if 'x' and 'y' are neighbors and false otherwise
-bool Graph::adjacent(char x, char y)
+bool Graph::adjacent(int x, int y)
 {
-    for(list<Node>::iterator i=adjList.begin(); i != adjList.end(); ++i)
-    {
-        if ((*i).number==nodeNumbers[x])
-        {
-            for(list<Node>::iterator j=(*i).edges.begin(); j != (*i).edges.end(); ++j)
-            {
-                if ((*j).number==nodeNumbers[y])
-                {
-                    return true;
-                }
-            }
-        }
-    }
+    for(vector<Node>::iterator j=edgesOf(x).begin(); j != edgesOf(x).end(); ++j)
+        if ((*j).number==y)
+            return true;
     return false;
 }
 
-// Returns a list<char> containing the list of neighbors of 'x'
-list<char> Graph::neighbors(char x)
+// Returns a vector<int> containing the list of neighbors of 'x'
+vector<int> Graph::neighbors(int x)
 {
-    list<char> adjNodes;
-    for(list<Node>::iterator i=adjList.begin(); i != adjList.end(); ++i)
-    {
-        if ((*i).number==nodeNumbers[x])
-        {
-            for(list<Node>::iterator j=(*i).edges.begin(); j != (*i).edges.end(); ++j)
-            {
-                adjNodes.push_back(nodeNames[(*j).number]);
-            }
-        }
-    }
+    vector<int> adjNodes;
+    for(vector<Node>::iterator j=edgesOf(x).begin(); j != edgesOf(x).end(); ++j)
+        adjNodes.push_back((*j).number);
     return adjNodes;
 }
 
@@ -242,29 +221,41 @@ int Graph::E()
     return numE;
 }
 
-// Returns a list<char> containing all nodes in the Graph
-list<char> Graph::vertices()
+// Returns a vector<int> containing all nodes in the Graph
+vector<int> Graph::vertices()
 {
-    list<char> nodes;
-    for(list<Node>::iterator i=adjList.begin(); i != adjList.end(); ++i)
-    {
-        nodes.push_back(nodeNames[(*i).number]);
-    }
+    vector<int> nodes;
+    for (int x=0; x<numV; ++x)
+        nodes.push_back(x);
     return nodes;
 }
 
+// Returns the graph in compressed sparse row form (vertices keep their node numbers)
+CSRGraph Graph::csr()
+{
+    vector<WeightedEdge> edges;
+    for (uint32_t x=0; x<adjList.size(); ++x)
+        for(vector<Node>::iterator j=adjList[x].begin(); j != adjList[x].end(); ++j)
+            if (x <= static_cast<uint32_t>((*j).number))
+            {
+                WeightedEdge e = {x, static_cast<uint32_t>((*j).number), (*j).weight};
+                edges.push_back(e);
+            }
+    return CSRGraph(static_cast<uint32_t>(adjList.size()), edges);
+}
+
 // Prints out adjacency list representing the Graph
 void Graph::show()
 {
     cout << "  ";
-    for(list<Node>::iterator i=adjList.begin(); i != adjList.end(); ++i)
-        cout << " " << nodeNames[(*i).number];
+    for (int x=0; x<numV; ++x)
+        cout << " " << get_node_value(x);
     cout << endl;
-    for(list<Node>::iterator i=adjList.begin(); i != adjList.end(); ++i)
+    for (int x=0; x<numV; ++x)
     {
-        cout << " " << nodeNames[(*i).number];
+        cout << " " << get_node_value(x);
         int shift=0;
-        for(list<Node>::iterator j=(*i).edges.begin(); j != (*i).edges.end(); ++j)
+        for(vector<Node>::iterator j=edgesOf(x).begin(); j != edgesOf(x).end(); ++j)
         {
             int walk=(*j).number-shift;
             for(int k=0; k<walk; ++k)
@@ -288,16 +279,16 @@ void Graph::show()
 
 struct strNodeInfo
 {
-    char nodeName;	// Node name
-    int minDist;		// Shortest path found to nodeName
-    char through;		// Node that precede nodeName in the shortest path
+    int node;		// Node number
+    int minDist;		// Shortest path found to node
+    int through;		// Node that precede node in the shortest path
 };
 typedef struct strNodeInfo NodeInfo;
 
-// Compares NodeInfo by nodeName
+// Compares NodeInfo by node number
 bool compareNodeName(NodeInfo& n1, NodeInfo& n2)
 {
-    if (n1.nodeName < n2.nodeName) return true;
+    if (n1.node < n2.node) return true;
     return false;
 }
 
@@ -308,18 +299,21 @@ bool compareMinDist(NodeInfo& n1, NodeInfo& n2)
     return false;
 }
 
-// Returns true if two NodeInfo have the same nodeName and false otherwise
+// Returns true if two NodeInfo have the same node and false otherwise
 bool operator== (NodeInfo& n1, NodeInfo& n2)
 {
-    if (n1.nodeName == n2.nodeName) return true;
+    if (n1.node == n2.node) return true;
     return false;
 }
 
 // PriorityQueue Class : To store known information about node names, min distances and paths (Ordered by min distances)
+// The queue is an indexed heap keyed by node number, so contains/isBetter are O(1) and insert/chgPriority are O(log V)
+// Heap is DaryHeap<D> or RadixHeap (see graph_heap.hpp)
 
-class PriorityQueue {
+template <class Heap>
+class BasicPriorityQueue {
 public:
-    PriorityQueue();
+    explicit BasicPriorityQueue(size_t numVertices = 256);
     void chgPriority(NodeInfo n);
     void minPriority();
     bool contains(NodeInfo n);
@@ -329,217 +323,611 @@ public:
     int size();
 
 private:
-    list<NodeInfo> pq;		// List of known nodes/paths ordered by minDist
+    static uint32_t slot(const NodeInfo& n) { return static_cast<uint32_t>(n.node); }	// Heap item of a node
+
+    Heap heap;			// Known nodes ordered by minDist (one slot per node number)
+    vector<int> through;		// Node that precedes each queued node in its path
 };
 
-// Creates an empty list of nodes
-PriorityQueue::PriorityQueue()
+typedef BasicPriorityQueue<DaryHeap<4> > PriorityQueue;
+
+// Creates an empty queue
+template <class Heap>
+BasicPriorityQueue<Heap>::BasicPriorityQueue(size_t numVertices) : heap(numVertices), through(numVertices)
 {
-    pq.clear();
 }
 
 // Changes information ('minDist' and 'through') of a node named 'n' in priority queue
-void PriorityQueue::chgPriority(NodeInfo n)
+template <class Heap>
+void BasicPriorityQueue<Heap>::chgPriority(NodeInfo n)
 {
-    for(list<NodeInfo>::iterator i=pq.begin(); i!=pq.end(); ++i)
-        if ((*i) == n)
-        {
-            (*i).minDist = n.minDist;
-            (*i).through = n.through;
-        }
-    pq.sort(compareMinDist);
+    if (!heap.contains(slot(n)))
+        return;
+    if (n.minDist < heap.key(slot(n)))
+        heap.decrease(slot(n), n.minDist);
+    through[slot(n)] = n.through;
 }
 
 // Removes the node with lower minDist from priority queue
-void PriorityQueue::minPriority()
+template <class Heap>
+void BasicPriorityQueue<Heap>::minPriority()
 {
-    if (! pq.empty())
-    {
-        pq.pop_front();
-    }
+    if (!heap.empty())
+        heap.pop();
 }
 
 // Returns true if there is a node named 'n' in priority queue and false otherwise
-bool PriorityQueue::contains(NodeInfo n)
+template <class Heap>
+bool BasicPriorityQueue<Heap>::contains(NodeInfo n)
 {
-    for(list<NodeInfo>::iterator i=pq.begin(); i!=pq.end(); ++i)
-        if ((*i).nodeName == n.nodeName)
-            return true;
-    return false;
+    return heap.contains(slot(n));
 }
 
 // Returns true if node 'n' has a lower minDist than the node with the same name in the priority queue and false otherwise
-bool PriorityQueue::isBetter(NodeInfo n)
+template <class Heap>
+bool BasicPriorityQueue<Heap>::isBetter(NodeInfo n)
 {
-    for(list<NodeInfo>::iterator i=pq.begin(); i!=pq.end(); ++i)
-        if ((*i).nodeName == n.nodeName)
-            if ((*i).minDist > n.minDist)
-                return true;
-    return false;
+    return heap.contains(slot(n)) && heap.key(slot(n)) > n.minDist;
 }
 
 // Inserts node 'n' into priority queue
-void PriorityQueue::insert(NodeInfo n)
+template <class Heap>
+void BasicPriorityQueue<Heap>::insert(NodeInfo n)
 {
-    pq.push_back(n);
-    pq.sort(compareMinDist);
+    heap.push(slot(n), n.minDist);
+    through[slot(n)] = n.through;
 }
 
 // Returns the node with lower minDist in priority queue (without removing it from the queue))
-NodeInfo PriorityQueue::top()
+template <class Heap>
+NodeInfo BasicPriorityQueue<Heap>::top()
 {
-    NodeInfo n = {' ',0};
-    if (! pq.empty())
+    NodeInfo n = {-1,0,-1};
+    if (!heap.empty())
     {
-        list<NodeInfo>::iterator i=pq.begin();
-        n.nodeName = (*i).nodeName;
-        n.minDist = (*i).minDist;
-        n.through = (*i).through;
+        uint32_t item = heap.top();
+        n.node = static_cast<int>(item);
+        n.minDist = static_cast<int>(heap.key(item));
+        n.through = through[item];
     }
     return n;
 }
 
 // Returns the number of elements in the priority queue
-int PriorityQueue::size()
+template <class Heap>
+int BasicPriorityQueue<Heap>::size()
+{
+    return static_cast<int>(heap.size());
+}
+
+// ShortestPathTree Class: All shortest paths from one source, as left by a complete Dijkstra run
+// dist and pred are computed once; path() walks pred back from the target in O(path length)
+
+class ShortestPathTree
+{
+public:
+    ShortestPathTree();
+    ShortestPathTree(int source, const vector<int>& dist, const vector<int>& pred);
+    int source();
+    bool reachable(int w);
+    int length(int w);
+    vector<int> path(int w);
+
+private:
+    int src;
+    vector<int> dist;		// Shortest path size to each node (INFINIT if not reached)
+    vector<int> pred;		// Node that precedes each node in its shortest path (-1 if not reached)
+};
+
+// Creates an empty tree
+ShortestPathTree::ShortestPathTree() : src(-1)
+{
+}
+
+// Creates a tree from the results of a search from 'source'
+ShortestPathTree::ShortestPathTree(int source, const vector<int>& d, const vector<int>& p) : src(source), dist(d), pred(p)
+{
+}
+
+// Returns the source node of the tree
+int ShortestPathTree::source()
+{
+    return src;
+}
+
+// Returns true if there is a path from the source to 'w' and false otherwise
+bool ShortestPathTree::reachable(int w)
+{
+    return pred[static_cast<size_t>(w)] >= 0;
+}
+
+// Returns the size of the shortest path from the source to 'w' (INFINIT if 'w' cannot be reached)
+int ShortestPathTree::length(int w)
+{
+    size_t i = static_cast<size_t>(w);
+    return pred[i] < 0 ? INFINIT : dist[i];
+}
+
+// Returns the nodes in the shortest path from the source to 'w' (empty if 'w' cannot be reached)
+vector<int> ShortestPathTree::path(int w)
 {
-    return pq.size();
+    vector<int> desiredPath;
+    if (pred[static_cast<size_t>(w)] < 0)
+        return desiredPath;
+    for (int x = w; x != src; x = pred[static_cast<size_t>(x)])
+        desiredPath.push_back(x);
+    desiredPath.push_back(src);
+    reverse(desiredPath.begin(), desiredPath.end());
+    return desiredPath;
 }
 
 // ShortestPath Class: Implementing Dijkstra's Algorithm
+// The graph is kept in CSR form, so each relaxation sweeps a vertex's neighbors in contiguous memory;
+// nodes are numbers, names are left to the caller (Graph::get_node_value)
+// path() / path_size() search in one of three modes (see graph_search.hpp for the point-to-point ones):
+//   DIJKSTRA       from 'u' until 'w' is settled, keeping the search for later queries from 'u'
+//   BIDIRECTIONAL  from 'u' and 'w' at once until the two searches meet
+//   ASTAR          from 'u', guided by a heuristic giving a lower bound on the distance to 'w'
+//   HIERARCHY      upward searches in a contraction hierarchy (see graph_ch.hpp), built by preprocess()
+//                  or load_hierarchy(), or on the first query
+// tree() always settles every node: by Dijkstra, or by parallel delta-stepping (see graph_delta.hpp) in
+// DELTA_STEPPING mode, where path() and path_size() also come from the full tree of 'u' (graphs with a zero
+// weight are searched by Dijkstra in this mode)
+// Edge weights may change while queries go on: set_edge_value() changes the graph, which can be shared
+// with other ShortestPath objects, and the shortest path trees of the sources registered with track()
+// are repaired rather than recomputed (see graph_dynamic.hpp); every query from those sources is
+// answered from their trees. Other results (last search, hierarchy) are dropped on any weight change.
+
+enum SearchMode { DIJKSTRA, BIDIRECTIONAL, ASTAR, HIERARCHY, DELTA_STEPPING };
 
 class ShortestPath
 {
 public:
     ShortestPath();
     ShortestPath(Graph g);
-    list<char> path(char u, char w);
-    int path_size(char u, char w);
+    ShortestPath(const CSRGraph& g);
+    ShortestPath(shared_ptr<CSRGraph> g);
+    vector<int> path(int u, int w);
+    int path_size(int u, int w);
+    ShortestPathTree tree(int u);
+    DistanceMatrix distances(const vector<int>& sources, unsigned threads = 0);
+    void set_mode(SearchMode m);
+    void set_heuristic(function<int(int v, int w)> h);
+    void set_delta(int delta, unsigned threads = 0);
+    int settled();
+    void preprocess();
+    bool save_hierarchy(const string& filename);
+    bool load_hierarchy(const string& filename);
+    bool set_edge_value(int x, int y, int value);
+    void track(int source);
+    void untrack(int source);
 
 private:
-    Graph graph;		// Graph used by algorithm
+    void refresh();
+    void search(int u, int w);
+    void searchPointToPoint(int u, int w);
+    bool pointToPoint();
+
+    shared_ptr<CSRGraph> graph;	// Graph used by algorithm (may be shared)
+    uint64_t graphVersion;	// graph->version() the results below were computed for
+    vector<int> dist, pred;	// Results of the last search (INFINIT / -1 where not settled)
+    int lastSource;
+    bool complete;		// The last search settled every node reachable from lastSource
+    SearchMode mode;
+    function<int(int, int)> heuristic;	// Lower bound on the distance from 'v' to 'w' (ASTAR)
+    PointToPoint p2p;		// Bidirectional / A* search state
+    ContractionHierarchy ch;	// Built for HIERARCHY mode
+    CHQuery chQuery;
+    DeltaStepping deltaStepping;	// Bound on the first DELTA_STEPPING search
+    int deltaWidth;		// Bucket width for delta-stepping (0 = automatic)
+    unsigned deltaThreads;	// Threads for delta-stepping (0 = one per hardware thread)
+    DynamicSSSP dynamic;	// Trees of the sources given to track()
+    int p2pSource, p2pTarget;	// Query answered by p2p
+    int numSettled;		// Nodes settled by the last search run
 };
 
 // Constructor of ShortestPath Class (do nothing)
-ShortestPath::ShortestPath()
+ShortestPath::ShortestPath() : graph(make_shared<CSRGraph>()), graphVersion(0), lastSource(-1), complete(false), mode(DIJKSTRA), deltaWidth(0), deltaThreads(0), p2pSource(-1), p2pTarget(-1), numSettled(0)
 {
 }
 
 // Constructor of ShortestPath Class that stores Graph used by Dijkstra's Algorithm
-ShortestPath::ShortestPath(Graph g)
+ShortestPath::ShortestPath(Graph g) : graph(make_shared<CSRGraph>(g.csr())), graphVersion(graph->version()), lastSource(-1), complete(false), mode(DIJKSTRA), deltaWidth(0), deltaThreads(0), p2pSource(-1), p2pTarget(-1), numSettled(0)
+{
+}
+
+// Constructor of ShortestPath Class working on a copy of a CSR graph
+ShortestPath::ShortestPath(const CSRGraph& g) : graph(make_shared<CSRGraph>(g)), graphVersion(graph->version()), lastSource(-1), complete(false), mode(DIJKSTRA), deltaWidth(0), deltaThreads(0), p2pSource(-1), p2pTarget(-1), numSettled(0)
+{
+}
+
+// Constructor of ShortestPath Class sharing a CSR graph: weight changes made through any of its users
+// are seen by the next query
+ShortestPath::ShortestPath(shared_ptr<CSRGraph> g) : graph(g), graphVersion(g->version()), lastSource(-1), complete(false), mode(DIJKSTRA), deltaWidth(0), deltaThreads(0), p2pSource(-1), p2pTarget(-1), numSettled(0)
+{
+}
+
+// Changes the weight of the existing edge between 'x' and 'y' (false if there is none) and repairs
+// the trees of the tracked sources
+bool ShortestPath::set_edge_value(int x, int y, int value)
+{
+    int32_t old;
+    uint32_t u = static_cast<uint32_t>(x), v = static_cast<uint32_t>(y);
+    if (!graph->edge(u, v, old) || !graph->setWeight(u, v, value))
+        return false;
+    if (dynamic.sources() > 0)
+        dynamic.weightChanged(u, v, old);
+    refresh();
+    return true;
+}
+
+// Keeps the shortest path tree from 'source' up to date across weight changes
+void ShortestPath::track(int source)
+{
+    if (dynamic.sources() == 0)
+        dynamic.bind(*graph);
+    dynamic.addSource(static_cast<uint32_t>(source));
+}
+
+// Stops maintaining the tree from 'source'
+void ShortestPath::untrack(int source)
 {
-    graph = g;
+    dynamic.removeSource(static_cast<uint32_t>(source));
 }
 
-// Returns a list<char> containing the list of nodes in the shortest path between 'u' and 'w'
-list<char> ShortestPath::path(char u, char w)
+// Drops the results computed before the last weight change
+void ShortestPath::refresh()
 {
-    // Initializes candidates list with all nodes
-    list<char> candidates = graph.vertices(), desiredPath;
-    list<NodeInfo> minPaths;
-    PriorityQueue p;
-    NodeInfo lastSelected, n;
+    if (graphVersion == graph->version())
+        return;
+    graphVersion = graph->version();
+    lastSource = -1;
+    complete = false;
+    p2p = PointToPoint();
+    p2pSource = p2pTarget = -1;
+    ch = ContractionHierarchy();
+    chQuery = CHQuery();
+    deltaStepping = DeltaStepping();
+    if (dynamic.sources() > 0)
+        dynamic.refresh();
+}
+
+// Selects the search used by path() and path_size()
+void ShortestPath::set_mode(SearchMode m)
+{
+    mode = m;
+    p2pSource = p2pTarget = -1;
+}
+
+// True if path() and path_size() run a point-to-point search
+bool ShortestPath::pointToPoint()
+{
+    return mode == BIDIRECTIONAL || mode == ASTAR || mode == HIERARCHY;
+}
+
+// Sets the bucket width (0 = largest edge weight over the average degree) and threads of DELTA_STEPPING searches
+void ShortestPath::set_delta(int delta, unsigned threads)
+{
+    deltaWidth = delta;
+    deltaThreads = threads;
+    deltaStepping = DeltaStepping();
+}
+
+// Sets the ASTAR heuristic: h(v, w) must never exceed the shortest path size from 'v' to 'w'
+// (without one, ASTAR behaves like DIJKSTRA)
+void ShortestPath::set_heuristic(function<int(int v, int w)> h)
+{
+    heuristic = h;
+    p2pSource = p2pTarget = -1;
+}
+
+// Returns the number of nodes settled by the last search run (a query answered from an earlier search runs none)
+int ShortestPath::settled()
+{
+    return numSettled;
+}
+
+// Builds the contraction hierarchy used by HIERARCHY mode
+void ShortestPath::preprocess()
+{
+    refresh();
+    ch.build(*graph);
+    p2pSource = p2pTarget = -1;
+}
+
+// Writes the contraction hierarchy to a file (built first if needed); false on I/O errors
+bool ShortestPath::save_hierarchy(const string& filename)
+{
+    if (ch.V() != graph->V())
+        preprocess();
+    return ch.save(filename);
+}
 
-    // Calculates shortest path from 'u' to 'w' (Dijkstra's Algorithm)
-    candidates.remove(u);			// Removes 'u' from candidates list
-    lastSelected.nodeName = u;		// Sets 'u' as lastSelected
-    lastSelected.minDist = 0;
-    lastSelected.through = u;
-    minPaths.push_back(lastSelected);	// Adds 'u' to minPath list
-    while ((!candidates.empty()) && (lastSelected.nodeName !=w))
+// Reads a contraction hierarchy written by save_hierarchy() for this graph; false if it cannot be read or was built
+// from a different graph (other arcs or weights)
+bool ShortestPath::load_hierarchy(const string& filename)
+{
+    refresh();
+    p2pSource = p2pTarget = -1;
+    if (!ch.load(filename))
+        return false;
+    if (ch.builtFrom(*graph))
+        return true;
+    ch = ContractionHierarchy();
+    return false;
+}
+
+// Bidirectional, A* or hierarchy search from 'u' to 'w'
+void ShortestPath::searchPointToPoint(int u, int w)
+{
+    refresh();
+    if (u == p2pSource && w == p2pTarget)
+        return;		// path_size() right after path()
+    uint32_t s = static_cast<uint32_t>(u), t = static_cast<uint32_t>(w);
+    if (mode == HIERARCHY)
+    {
+        if (ch.V() != graph->V())
+            preprocess();
+        chQuery.bind(ch);
+        chQuery.query(s, t);
+        p2pSource = u;
+        p2pTarget = w;
+        numSettled = static_cast<int>(chQuery.settled());
+        return;
+    }
+    p2p.bind(*graph);
+    if (mode == BIDIRECTIONAL)
+        p2p.bidirectional(s, t);
+    else if (heuristic)
+        p2p.astar(s, t, [this, w](uint32_t v) { return static_cast<int64_t>(heuristic(static_cast<int>(v), w)); });
+    else
+        p2p.dijkstra(s, t);
+    p2pSource = u;
+    p2pTarget = w;
+    numSettled = static_cast<int>(p2p.settled());
+}
+
+// Dijkstra's algorithm from node number 'u', stopping once 'w' is settled ('w' = -1 settles every node)
+void ShortestPath::search(int u, int w)
+{
+    refresh();
+    if (u == lastSource && (complete || (w >= 0 && pred[static_cast<size_t>(w)] >= 0)))
+        return;		// Answered by the last search (e.g. path_size() right after path())
+    uint32_t n = graph->V();
+    if (mode == DELTA_STEPPING && deltaStepping.V() != graph->V())
+        deltaStepping.bind(*graph, deltaWidth);
+    // Zero weights could turn the delta-stepping predecessors into cycles: such graphs are left to Dijkstra
+    if (mode == DELTA_STEPPING && deltaStepping.positiveWeights())
     {
-        // For each node in candidate list calculate the cost to reach that candidate through lastSelected
-        for(list<char>::iterator i=candidates.begin(); i != candidates.end(); ++i)
+        // Every node at once, in parallel
+        dist.assign(graph->V(), INFINIT);
+        pred.assign(graph->V(), -1);
+        vector<int32_t> d(graph->V());
+        deltaStepping.run(static_cast<uint32_t>(u), deltaThreads, d.data(), pred.data());
+        numSettled = 0;
+        for (size_t v=0; v<d.size(); ++v)
+            if (pred[v] >= 0)
+            {
+                dist[v] = d[v];
+                ++numSettled;
+            }
+        lastSource = u;
+        complete = true;
+        return;
+    }
+    PriorityQueue p(n);
+    vector<char> settled(n, 0);
+    numSettled = 0;
+    dist.assign(n, INFINIT);
+    pred.assign(n, -1);
+    NodeInfo start = {u, 0, u};
+    p.insert(start);
+    dist[static_cast<size_t>(u)] = 0;
+    bool stopped = false;	// Left at 'w' before relaxing its arcs
+    while (p.size() > 0)
+    {
+        NodeInfo lastSelected = p.top();	// Selects the candidate with minDist from priority queue
+        p.minPriority();			// Removes it from the priority queue
+        uint32_t selected = static_cast<uint32_t>(lastSelected.node);
+        settled[selected] = 1;
+        ++numSettled;
+        pred[selected] = lastSelected.through;
+        if (lastSelected.node == w)
+        {
+            stopped = true;
+            break;
+        }
+        // Cost to reach each neighbor through lastSelected
+        EdgeRange adj = graph->neighbors(selected);
+        for (size_t i=0; i<adj.size(); ++i)
         {
-            n.nodeName=*i;
-            n.minDist=lastSelected.minDist+graph.get_edge_value(lastSelected.nodeName,*i);
-            n.through=lastSelected.nodeName;
-            if (!p.contains(n))	// Adds candidate to priority queue if doesn't exist
-                p.insert(n);
+            NodeInfo next = {static_cast<int>(adj.to[i]), lastSelected.minDist + adj.weight[i], lastSelected.node};
+            if (settled[adj.to[i]])
+                continue;
+            if (!p.contains(next))	// Adds candidate to priority queue if doesn't exist
+                p.insert(next);
             else
-            if (p.isBetter(n))	// Updates candidate minDist in priority queue if a better path was found
-                p.chgPriority(n);
+            if (p.isBetter(next))	// Updates candidate minDist in priority queue if a better path was found
+                p.chgPriority(next);
+            else
+                continue;
+            dist[adj.to[i]] = next.minDist;
         }
-        lastSelected = p.top();			// Selects the candidate with minDist from priority queue
-        p.minPriority();				// Removes it from the priority queue
-        minPaths.push_back(lastSelected);		// Adds the candidate with min distance to minPath list
-        candidates.remove(lastSelected.nodeName);	// Removes it from candidates list
     }
+    lastSource = u;
+    complete = !stopped;
+}
 
-    // Go backward from 'w' to 'u' adding nodes in that path to desiredPath list
-    lastSelected=minPaths.back();
-    desiredPath.push_front(lastSelected.nodeName);
-    while(lastSelected.nodeName!=u)
+// Returns a vector<int> containing the nodes in the shortest path between 'u' and 'w'
+// (empty if 'w' cannot be reached)
+vector<int> ShortestPath::path(int u, int w)
+{
+    if (dynamic.hasSource(static_cast<uint32_t>(u)))
     {
-        for(list<NodeInfo>::iterator i=minPaths.begin(); i != minPaths.end(); ++i)
-            if ((*i).nodeName==lastSelected.through)
-            {
-                lastSelected=(*i);
-                desiredPath.push_front(lastSelected.nodeName);
-            }
+        refresh();
+        vector<uint32_t> p = dynamic.path(static_cast<uint32_t>(u), static_cast<uint32_t>(w));
+        return vector<int>(p.begin(), p.end());
     }
-    return desiredPath;
+    if (pointToPoint())
+    {
+        searchPointToPoint(u, w);
+        vector<uint32_t> p = mode == HIERARCHY ? chQuery.path() : p2p.path();
+        return vector<int>(p.begin(), p.end());
+    }
+    search(u, w);
+    return ShortestPathTree(u, dist, pred).path(w);
 }
 
-// Returns the size of the shortest path between 'u' and 'w'
-int ShortestPath::path_size(char u, char w)
+// Returns the size of the shortest path between 'u' and 'w' (INFINIT if 'w' cannot be reached)
+int ShortestPath::path_size(int u, int w)
 {
-    int pathCost=0;
-    list<char> sp;
-    char current,next;
+    if (dynamic.hasSource(static_cast<uint32_t>(u)))
+    {
+        refresh();
+        int64_t length = dynamic.distance(static_cast<uint32_t>(u), static_cast<uint32_t>(w));
+        return length < 0 ? INFINIT : static_cast<int>(length);
+    }
+    if (pointToPoint())
+    {
+        searchPointToPoint(u, w);
+        int64_t length = mode == HIERARCHY ? chQuery.length() : p2p.length();
+        return length < 0 ? INFINIT : static_cast<int>(length);
+    }
+    search(u, w);
+    size_t i = static_cast<size_t>(w);
+    return pred[i] < 0 ? INFINIT : dist[i];
+}
 
-    // Calculates the shortest path from 'u' to 'w' and then sum up edge weights in this path
-    sp = path(u,w);
-    current=sp.front();
-    sp.pop_front();
-    for(list<char>::iterator i=sp.begin(); i!=sp.end(); ++i)
+// Returns the shortest paths from 'u' to every node, computed with a single Dijkstra run
+ShortestPathTree ShortestPath::tree(int u)
+{
+    if (dynamic.hasSource(static_cast<uint32_t>(u)))
     {
-        next = (*i);
-        pathCost += graph.get_edge_value(current,next);
-        current = next;
+        refresh();
+        uint32_t s = static_cast<uint32_t>(u), n = graph->V();
+        vector<int> d(n, INFINIT), p(n, -1);
+        for (uint32_t v=0; v<n; ++v)
+        {
+            int64_t length = dynamic.distance(s, v);
+            if (length >= 0)
+            {
+                d[v] = static_cast<int>(length);
+                p[v] = static_cast<int>(dynamic.predecessor(s, v));
+            }
+        }
+        return ShortestPathTree(u, d, p);
     }
-    return pathCost;
+    search(u, -1);
+    return ShortestPathTree(u, dist, pred);
+}
+
+// Returns the distances from each node in 'sources' to every node (with predecessors, see DistanceMatrix::path),
+// searching from the sources in parallel on 'threads' threads (0 = one per hardware thread)
+DistanceMatrix ShortestPath::distances(const vector<int>& sources, unsigned threads)
+{
+    vector<uint32_t> s(sources.begin(), sources.end());
+    refresh();
+    return multiSourceDistances(*graph, s, threads, true);
+}
+
+// Returns the names of a list of nodes, each followed by a space
+static string nodeList(Graph& g, const vector<int>& nodes)
+{
+    string out;
+    for (size_t i=0; i<nodes.size(); ++i)
+        out += g.get_node_value(nodes[i]) + " ";
+    return out;
 }
 
 // Monte Carlo Class : To generate random graphs and run simulations
 
+// TrialConfig: one point of a batch simulation, 'trials' random graphs with the same parameters
+struct TrialConfig
+{
+    int vertices;
+    double density;
+    int minDistEdge;
+    int maxDistEdge;
+    int trials;
+};
+
+// TrialSummary: statistics over the trials of one TrialConfig, from the shortest paths between all
+// pairs of nodes of each graph:
+//   reachability  fraction of ordered pairs of distinct nodes joined by a path
+//   meanPath      mean shortest path size over those pairs (graphs with no such pair are left out)
+//   diameter      largest shortest path size (0 if no pair is joined)
+struct TrialSummary
+{
+    TrialConfig config;
+    RunningStats reachability;
+    RunningStats meanPath;
+    RunningStats diameter;
+};
+
+// MonteCarlo Class: random graphs and shortest path simulations on them
+// Graph number k of a simulation is drawn from its own stream, mixSeed(seed, k) (see graph_random.hpp),
+// so a seed reproduces the whole run, whether the graphs are made one by one or many at once in parallel
 class MonteCarlo
 {
 public:
     MonteCarlo();
+    MonteCarlo(uint64_t seed);
+    uint64_t seed();
     Graph randomGraph(int vert, double density, int minDistEdge, int maxDistEdge);
+    CSRGraph randomCSR(int vert, double density, int minDistEdge, int maxDistEdge, unsigned threads = 1);
+    vector<CSRGraph> randomGraphs(int count, int vert, double density, int minDistEdge, int maxDistEdge, unsigned threads = 0);
     void run(Graph g);
+    vector<TrialSummary> runBatch(const vector<TrialConfig>& configs, unsigned threads = 0, bool verbose = false);
 
 private:
+    uint64_t seedValue;		// Seed of the simulation
+    uint64_t generated;		// Number of graphs generated so far
 };
 
-// Initializes the seed of random number generator
-MonteCarlo::MonteCarlo()
+// Seeds the simulation with the current time (seed() tells which, to repeat the run)
+MonteCarlo::MonteCarlo() : seedValue(static_cast<uint64_t>(time(NULL))), generated(0)
 {
-    srand(time(NULL));
 }
 
-// Returns a random Graph generated with number of nodes, density and edge weight range informed
-Graph MonteCarlo::randomGraph(int numVert, double density, int minDistEdge, int maxDistEdge)
+// Seeds the simulation with a given seed
+MonteCarlo::MonteCarlo(uint64_t seed) : seedValue(seed), generated(0)
 {
-    int randDistEdge;
-    char srcVert, dstVert;
+}
 
-    Graph g(numVert);
+// Returns the seed of the simulation
+uint64_t MonteCarlo::seed()
+{
+    return seedValue;
+}
 
-    for (int i=0; i<g.V(); ++i)
-        for (int j=i+1; j<g.V(); ++j)
-        {
-            double p = ((static_cast<double>(rand())) / RAND_MAX);	// Generate random probability
-            if (p < density)	// If random probability is less than density, edge (i,j) will be set
-            {
-                randDistEdge = rand() % (maxDistEdge - minDistEdge) + minDistEdge; // Generate random edge weight
-                srcVert = vertIntToChar(i);
-                dstVert = vertIntToChar(j);
-                g.set_edge_value(srcVert,dstVert,randDistEdge);
-            }
-        }
+// Returns a random Graph generated with number of nodes, density and edge weight range informed:
+// each pair of nodes is joined with probability 'density', by an edge of weight in [minDistEdge, maxDistEdge)
+Graph MonteCarlo::randomGraph(int numVert, double density, int minDistEdge, int maxDistEdge)
+{
+    uint64_t graphSeed = mixSeed(seedValue, generated++);
+    return Graph(numVert, gnpEdges(static_cast<uint32_t>(numVert), density, minDistEdge, maxDistEdge, graphSeed));
+}
 
-    return g;
+// Same as randomGraph(), straight into CSR form; a large graph can be generated on several threads
+// (0 = one per hardware thread) without changing the result
+CSRGraph MonteCarlo::randomCSR(int numVert, double density, int minDistEdge, int maxDistEdge, unsigned threads)
+{
+    uint64_t graphSeed = mixSeed(seedValue, generated++);
+    return gnpGraph(static_cast<uint32_t>(numVert), density, minDistEdge, maxDistEdge, graphSeed, threads);
+}
+
+// Returns the next 'count' random graphs, generated in parallel on 'threads' threads (0 = one per hardware thread);
+// they are the graphs 'count' calls of randomCSR() would return
+vector<CSRGraph> MonteCarlo::randomGraphs(int count, int numVert, double density, int minDistEdge, int maxDistEdge, unsigned threads)
+{
+    vector<CSRGraph> graphs(static_cast<size_t>(max(count, 0)));
+    uint64_t first = generated;
+    generated += graphs.size();
+    runStealing(threads, graphs.size(), [&](size_t k, size_t)
+    {
+        graphs[k] = gnpGraph(static_cast<uint32_t>(numVert), density, minDistEdge, maxDistEdge, mixSeed(seedValue, first + k));
+    });
+    return graphs;
 }
 
 // Runs a simulation finding the shortest paths in a given graph
@@ -557,20 +945,22 @@ void MonteCarlo::run(Graph g)
     g.show();
 
     // Prints out shortest path information
-    list<char> v = g.vertices();
-    cout << endl << "Vertices: " << v << endl;
-    int reachVert=0, sumPathSize=0, avgPathSize=0;
+    vector<int> v = g.vertices();
+    cout << endl << "Vertices: " << nodeList(g, v) << endl;
+    int reachVert=0, sumPathSize=0;
+    double avgPathSize=0;
     ShortestPath sp(g);
-    for (list<char>::iterator i=++v.begin(); i != v.end(); ++i)
+    int src = v.front();
+    ShortestPathTree t = sp.tree(src);	// One search answers every destination
+    for (vector<int>::iterator i=v.begin()+1; i != v.end(); ++i)
     {
-        char src = v.front();
-        char dst = (*i);
-        list<char> p = sp.path(src,dst);
-        int ps = sp.path_size(src,dst);
+        int dst = (*i);
+        vector<int> p = t.path(dst);
+        int ps = t.length(dst);
         if (ps != INFINIT)
-            cout << "ShortestPath (" << src << " to " << dst << "): " << ps << " -> " << p << endl;
+            cout << "ShortestPath (" << g.get_node_value(src) << " to " << g.get_node_value(dst) << "): " << ps << " -> " << nodeList(g, p) << endl;
         else
-            cout << "ShortestPath (" << src << " to " << dst << "): " << "** UNREACHABLE **" << endl;
+            cout << "ShortestPath (" << g.get_node_value(src) << " to " << g.get_node_value(dst) << "): " << "** UNREACHABLE **" << endl;
         if (ps!=INFINIT)
         {
             reachVert++;		// Sums up reached nodes
@@ -580,15 +970,692 @@ void MonteCarlo::run(Graph g)
 
     // Calculates average shortest path and print it out
     if (reachVert!=0)
-        avgPathSize = sumPathSize / reachVert;
-    else
-        avgPathSize = 0;
+        avgPathSize = static_cast<double>(sumPathSize) / reachVert;
     cout << endl << "AVG ShortestPath Size (reachVert: " << reachVert << " - sumPathSize: " << sumPathSize << "): " << avgPathSize << endl;
 }
 
-int main()
+// Runs the trials of every configuration on 'threads' threads (0 = one per hardware thread) and returns
+// their statistics, printing nothing unless 'verbose' (then one line per trial to cerr, in trial order).
+// Trials are split into chunks of a fixed size, each summed up on its own and merged in order, so the
+// summaries are the same on any number of threads.
+vector<TrialSummary> MonteCarlo::runBatch(const vector<TrialConfig>& configs, unsigned threads, bool verbose)
+{
+    const int chunkSize = 16;
+    struct Chunk
+    {
+        size_t config;
+        int firstTrial, lastTrial;
+        uint64_t firstGraph;	// Number of the graph of firstTrial in this simulation
+        TrialSummary part;
+        string log;
+    };
+    vector<Chunk> chunks;
+    for (size_t c = 0; c < configs.size(); ++c)
+    {
+        for (int t = 0; t < configs[c].trials; t += chunkSize)
+        {
+            Chunk chunk;
+            chunk.config = c;
+            chunk.firstTrial = t;
+            chunk.lastTrial = min(t + chunkSize, configs[c].trials);
+            chunk.firstGraph = generated + static_cast<uint64_t>(t);
+            chunks.push_back(chunk);
+        }
+        generated += static_cast<uint64_t>(max(configs[c].trials, 0));
+    }
+
+    // One row of distances at a time, so memory stays O(V) per thread
+    struct Scratch
+    {
+        SSSPScratch sssp;
+        vector<int32_t> row;
+    };
+    vector<Scratch> scratch(workerCount(threads));
+    runStealing(threads, chunks.size(), [&](size_t k, size_t worker)
+    {
+        Chunk& chunk = chunks[k];
+        const TrialConfig& config = configs[chunk.config];
+        Scratch& s = scratch[worker];
+        ostringstream log;
+        for (int t = chunk.firstTrial; t < chunk.lastTrial; ++t)
+        {
+            uint64_t graphSeed = mixSeed(seedValue, chunk.firstGraph + static_cast<uint64_t>(t - chunk.firstTrial));
+            CSRGraph g = gnpGraph(static_cast<uint32_t>(config.vertices), config.density, config.minDistEdge, config.maxDistEdge, graphSeed);
+            s.row.resize(g.V());
+            long long pairs = 0, sum = 0;
+            int32_t diameter = 0;
+            for (uint32_t u = 0; u < g.V(); ++u)
+            {
+                dijkstraRow(g, u, s.sssp, s.row.data(), NULL);
+                for (uint32_t v = 0; v < g.V(); ++v)
+                    if (v != u && s.row[v] < DistanceMatrix::INF)
+                    {
+                        ++pairs;
+                        sum += s.row[v];
+                        diameter = max(diameter, s.row[v]);
+                    }
+            }
+            double n = static_cast<double>(g.V());
+            double reach = n > 1 ? static_cast<double>(pairs) / (n * (n - 1)) : 0;
+            chunk.part.reachability.add(reach);
+            if (pairs > 0)
+                chunk.part.meanPath.add(static_cast<double>(sum) / static_cast<double>(pairs));
+            chunk.part.diameter.add(diameter);
+            if (verbose)
+                log << "vertices " << config.vertices << " density " << config.density << " weights " << config.minDistEdge << "-" << config.maxDistEdge
+                    << " trial " << t + 1 << ": edges " << g.E() << ", reachability " << reach << ", mean path "
+                    << (pairs > 0 ? static_cast<double>(sum) / static_cast<double>(pairs) : 0) << ", diameter " << diameter << endl;
+        }
+        chunk.log = log.str();
+    });
+
+    vector<TrialSummary> summaries(configs.size());
+    for (size_t c = 0; c < configs.size(); ++c)
+        summaries[c].config = configs[c];
+    for (size_t k = 0; k < chunks.size(); ++k)
+    {
+        TrialSummary& sum = summaries[chunks[k].config];
+        sum.reachability.merge(chunks[k].part.reachability);
+        sum.meanPath.merge(chunks[k].part.meanPath);
+        sum.diameter.merge(chunks[k].part.diameter);
+        cerr << chunks[k].log;
+    }
+    return summaries;
+}
+
+// Writes batch summaries as CSV (a header, then one line per configuration) or as a JSON array
+static void writeSummaries(ostream& out, const vector<TrialSummary>& summaries, bool json)
+{
+    const char* names[] = {"reachability", "mean_path", "diameter"};
+    if (!json)
+    {
+        out << "vertices,density,min_weight,max_weight,trials";
+        for (int m = 0; m < 3; ++m)
+            out << "," << names[m] << "_mean," << names[m] << "_stddev," << names[m] << "_min," << names[m] << "_max";
+        out << endl;
+    }
+    else
+        out << "[";
+    out << setprecision(6);
+    for (size_t i = 0; i < summaries.size(); ++i)
+    {
+        const TrialSummary& s = summaries[i];
+        const RunningStats* stats[] = {&s.reachability, &s.meanPath, &s.diameter};
+        if (!json)
+        {
+            out << s.config.vertices << "," << s.config.density << "," << s.config.minDistEdge << "," << s.config.maxDistEdge << "," << s.config.trials;
+            for (int m = 0; m < 3; ++m)
+                out << "," << stats[m]->mean() << "," << stats[m]->stddev() << "," << stats[m]->minimum() << "," << stats[m]->maximum();
+            out << endl;
+            continue;
+        }
+        out << (i > 0 ? "," : "") << endl << "  {\"vertices\": " << s.config.vertices << ", \"density\": " << s.config.density
+            << ", \"min_weight\": " << s.config.minDistEdge << ", \"max_weight\": " << s.config.maxDistEdge << ", \"trials\": " << s.config.trials;
+        for (int m = 0; m < 3; ++m)
+            out << "," << endl << "   \"" << names[m] << "\": {\"count\": " << stats[m]->count() << ", \"mean\": " << stats[m]->mean()
+                << ", \"stddev\": " << stats[m]->stddev() << ", \"min\": " << stats[m]->minimum() << ", \"max\": " << stats[m]->maximum() << "}";
+        out << "}";
+    }
+    if (json)
+        out << endl << "]" << endl;
+}
+
+// Dijkstra from src over a CSR graph with an indexed heap; returns the sum of reachable distances
+template <class Heap>
+long long dijkstraHeap(const CSRGraph& g, uint32_t src, Heap& heap)
+{
+    vector<long long> dist(g.V(), -1);
+    vector<char> done(g.V(), 0);
+    long long sum = 0;
+    heap.reset(g.V());
+    heap.push(src, 0);
+    dist[src] = 0;
+    while (!heap.empty())
+    {
+        uint32_t u = heap.top();
+        long long du = heap.topKey();
+        heap.pop();
+        done[u] = 1;
+        sum += du;
+        EdgeRange adj = g.neighbors(u);
+        for (size_t e = 0; e < adj.size(); ++e)
+        {
+            uint32_t v = adj.to[e];
+            long long dv = du + adj.weight[e];
+            if (done[v])
+                continue;
+            if (!heap.contains(v))
+            {
+                dist[v] = dv;
+                heap.push(v, dv);
+            }
+            else if (dv < dist[v])
+            {
+                dist[v] = dv;
+                heap.decrease(v, dv);
+            }
+        }
+    }
+    return sum;
+}
+
+// Baseline: std::priority_queue without decrease-key (stale entries are skipped when popped)
+static long long dijkstraLazy(const CSRGraph& g, uint32_t src)
+{
+    typedef pair<long long,uint32_t> Item;
+    priority_queue<Item, vector<Item>, greater<Item> > pq;
+    vector<long long> dist(g.V(), -1);
+    vector<char> done(g.V(), 0);
+    long long sum = 0;
+    pq.push(Item(0, src));
+    dist[src] = 0;
+    while (!pq.empty())
+    {
+        Item top = pq.top();
+        pq.pop();
+        if (done[top.second])
+            continue;
+        done[top.second] = 1;
+        sum += top.first;
+        EdgeRange adj = g.neighbors(top.second);
+        for (size_t e = 0; e < adj.size(); ++e)
+        {
+            uint32_t v = adj.to[e];
+            long long dv = top.first + adj.weight[e];
+            if (!done[v] && (dist[v] < 0 || dv < dist[v]))
+            {
+                dist[v] = dv;
+                pq.push(Item(dv, v));
+            }
+        }
+    }
+    return sum;
+}
+
+// Times one Dijkstra run per queue on random graphs like MonteCarlo::randomGraph (weights 1..10),
+// with 10^3 .. maxVert vertices and an average degree of about 10 so the largest ones fit in memory
+static void benchHeaps(int maxVert)
+{
+    cout << setw(10) << "vertices" << setw(12) << "edges" << setw(14) << "queue" << setw(12) << "seconds" << setw(18) << "checksum" << endl;
+    for (int n = 1000; n <= maxVert; n *= 10)
+    {
+        vector<WeightedEdge> edges;
+        long long m = 5LL * n;
+        for (long long e = 0; e < m; ++e)
+        {
+            WeightedEdge edge;
+            edge.from = static_cast<uint32_t>((static_cast<long long>(rand()) * RAND_MAX + rand()) % n);
+            edge.to = static_cast<uint32_t>((static_cast<long long>(rand()) * RAND_MAX + rand()) % n);
+            edge.weight = rand() % 10 + 1;
+            edges.push_back(edge);
+        }
+        CSRGraph adj(static_cast<uint32_t>(n), edges);
+        m = static_cast<long long>(adj.E());
+        auto timeIt = [&](const char* name, auto&& run)
+        {
+            auto t0 = chrono::steady_clock::now();
+            long long check = run();
+            double sec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+            cout << setw(10) << n << setw(12) << m << setw(14) << name << setw(12) << fixed << setprecision(4) << sec << setw(18) << check << endl;
+        };
+        DaryHeap<2> binary;
+        DaryHeap<4> quad;
+        DaryHeap<8> oct;
+        RadixHeap radix;
+        timeIt("lazy binary", [&] { return dijkstraLazy(adj, 0); });
+        timeIt("2-ary", [&] { return dijkstraHeap(adj, 0, binary); });
+        timeIt("4-ary", [&] { return dijkstraHeap(adj, 0, quad); });
+        timeIt("8-ary", [&] { return dijkstraHeap(adj, 0, oct); });
+        timeIt("radix", [&] { return dijkstraHeap(adj, 0, radix); });
+    }
+}
+
+// Sum of the reachable entries of a distance matrix
+static long long matrixChecksum(const DistanceMatrix& m)
+{
+    long long sum = 0;
+    for (size_t r = 0; r < m.rows(); ++r)
+        for (uint32_t v = 0; v < m.V(); ++v)
+            if (m.at(r, v) < DistanceMatrix::INF)
+                sum += m.at(r, v);
+    return sum;
+}
+
+// Multi-source throughput in sources/second for 1, 2, 4 .. maxThreads threads on a sparse random graph
+// with numVert vertices (average degree about 10), then all-pairs by Dijkstra against blocked
+// Floyd-Warshall on a dense 1000-vertex graph
+static void benchAPSP(int numVert, unsigned maxThreads)
+{
+    auto randomEdges = [](int n, long long m)
+    {
+        vector<WeightedEdge> edges;
+        for (long long e = 0; e < m; ++e)
+        {
+            WeightedEdge edge;
+            edge.from = static_cast<uint32_t>((static_cast<long long>(rand()) * RAND_MAX + rand()) % n);
+            edge.to = static_cast<uint32_t>((static_cast<long long>(rand()) * RAND_MAX + rand()) % n);
+            edge.weight = rand() % 10 + 1;
+            edges.push_back(edge);
+        }
+        return edges;
+    };
+    auto seconds = [](chrono::steady_clock::time_point t0)
+    {
+        return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    };
+
+    CSRGraph sparse(static_cast<uint32_t>(numVert), randomEdges(numVert, 5LL * numVert));
+    vector<uint32_t> sources;
+    for (int v = 0; v < numVert && v < 1000; ++v)
+        sources.push_back(static_cast<uint32_t>(v));
+    cout << "Multi-source Dijkstra: " << sparse.V() << " vertices, " << sparse.E() << " edges, " << sources.size() << " sources" << endl;
+    cout << setw(10) << "threads" << setw(12) << "seconds" << setw(16) << "sources/sec" << setw(18) << "checksum" << endl;
+    for (unsigned t = 1; t <= maxThreads; t = t < maxThreads && t * 2 > maxThreads ? maxThreads : t * 2)
+    {
+        auto t0 = chrono::steady_clock::now();
+        DistanceMatrix m = multiSourceDistances(sparse, sources, t);
+        double sec = seconds(t0);
+        cout << setw(10) << t << setw(12) << fixed << setprecision(4) << sec << setw(16) << setprecision(1) << sources.size() / sec
+             << setw(18) << matrixChecksum(m) << endl;
+    }
+
+    int denseVert = 1000;
+    CSRGraph dense(static_cast<uint32_t>(denseVert), randomEdges(denseVert, 200LL * denseVert));
+    cout << endl << "All pairs: " << dense.V() << " vertices, " << dense.E() << " edges, " << maxThreads << " threads" << endl;
+    cout << setw(20) << "method" << setw(12) << "seconds" << setw(16) << "sources/sec" << setw(18) << "checksum" << endl;
+    auto t0 = chrono::steady_clock::now();
+    DistanceMatrix byDijkstra = allPairsDistances(dense, maxThreads);
+    double sec = seconds(t0);
+    cout << setw(20) << "dijkstra" << setw(12) << setprecision(4) << sec << setw(16) << setprecision(1) << denseVert / sec
+         << setw(18) << matrixChecksum(byDijkstra) << endl;
+    t0 = chrono::steady_clock::now();
+    DistanceMatrix byFloyd = floydWarshall(dense, maxThreads);
+    sec = seconds(t0);
+    cout << setw(20) << "floyd-warshall" << setw(12) << setprecision(4) << sec << setw(16) << setprecision(1) << denseVert / sec
+         << setw(18) << matrixChecksum(byFloyd) << endl;
+}
+
+// Returns a side x side grid graph with coordinates (10 units apart, in x and y) and edge weights 10..19,
+// so the straight-line distance is an admissible A* heuristic
+static CSRGraph gridGraph(int side, vector<double>& x, vector<double>& y)
 {
-    MonteCarlo simulation;
+    int n = side * side;
+    x.assign(static_cast<size_t>(n), 0);
+    y.assign(static_cast<size_t>(n), 0);
+    vector<WeightedEdge> edges;
+    for (int r = 0; r < side; ++r)
+        for (int c = 0; c < side; ++c)
+        {
+            int v = r * side + c;
+            x[static_cast<size_t>(v)] = 10.0 * c;
+            y[static_cast<size_t>(v)] = 10.0 * r;
+            if (c + 1 < side)
+                edges.push_back(WeightedEdge{static_cast<uint32_t>(v), static_cast<uint32_t>(v + 1), 10 + rand() % 10});
+            if (r + 1 < side)
+                edges.push_back(WeightedEdge{static_cast<uint32_t>(v), static_cast<uint32_t>(v + side), 10 + rand() % 10});
+        }
+    return CSRGraph(static_cast<uint32_t>(n), edges);
+}
+
+// Point-to-point queries on a side x side grid; reports settled nodes and time per query
+static void benchPointToPoint(int side, int queries)
+{
+    int n = side * side;
+    vector<double> x, y;
+    CSRGraph g = gridGraph(side, x, y);
+    vector<pair<int,int> > pairs;
+    for (int q = 0; q < queries; ++q)
+        pairs.push_back(make_pair(rand() % n, rand() % n));
+
+    cout << "Point-to-point: " << g.V() << " vertices, " << g.E() << " edges, " << queries << " queries" << endl;
+    cout << setw(16) << "mode" << setw(16) << "settled/query" << setw(14) << "ms/query" << setw(18) << "checksum" << endl;
+    const char* names[] = {"dijkstra", "bidirectional", "astar"};
+    SearchMode modes[] = {DIJKSTRA, BIDIRECTIONAL, ASTAR};
+    ShortestPath sp(g);
+    sp.set_heuristic([&](int v, int w) noexcept
+    {
+        size_t i = static_cast<size_t>(v), j = static_cast<size_t>(w);
+        return static_cast<int>(hypot(x[i] - x[j], y[i] - y[j]));
+    });
+    for (int m = 0; m < 3; ++m)
+    {
+        sp.set_mode(modes[m]);
+        long long settled = 0, check = 0;
+        auto t0 = chrono::steady_clock::now();
+        for (size_t q = 0; q < pairs.size(); ++q)
+        {
+            check += sp.path_size(pairs[q].first, pairs[q].second);
+            settled += sp.settled();
+        }
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count() / queries;
+        cout << setw(16) << names[m] << setw(16) << settled / queries << setw(14) << fixed << setprecision(3) << ms << setw(18) << check << endl;
+    }
+}
+
+// Contraction hierarchy on a side x side grid: preprocessing, save and load times against query latency
+// with and without the hierarchy (bidirectional Dijkstra)
+static void benchHierarchy(int side, int queries)
+{
+    int n = side * side;
+    vector<double> x, y;
+    CSRGraph g = gridGraph(side, x, y);
+    vector<pair<int,int> > pairs;
+    for (int q = 0; q < queries; ++q)
+        pairs.push_back(make_pair(rand() % n, rand() % n));
+    auto seconds = [](chrono::steady_clock::time_point t0)
+    {
+        return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    };
+    cout << "Contraction hierarchy: " << g.V() << " vertices, " << g.E() << " edges" << endl;
+
+    ShortestPath sp(g);
+    auto t0 = chrono::steady_clock::now();
+    sp.preprocess();
+    double build = seconds(t0);
+    string file = "dijkstra_bench.ch";
+    t0 = chrono::steady_clock::now();
+    bool saved = sp.save_hierarchy(file);
+    double save = seconds(t0);
+    ShortestPath loaded(g);
+    t0 = chrono::steady_clock::now();
+    bool ok = saved && loaded.load_hierarchy(file);
+    double load = seconds(t0);
+    remove(file.c_str());
+    if (!ok)
+    {
+        cout << "Cannot write or read " << file << endl;
+        return;
+    }
+    cout << "preprocessing " << fixed << setprecision(3) << build << " s, save " << save << " s, load " << load << " s" << endl << endl;
+
+    cout << setw(16) << "mode" << setw(16) << "settled/query" << setw(14) << "us/query" << setw(18) << "checksum" << endl;
+    double perQuery[2];
+    const char* names[] = {"bidirectional", "hierarchy"};
+    SearchMode modes[] = {BIDIRECTIONAL, HIERARCHY};
+    for (int m = 0; m < 2; ++m)
+    {
+        loaded.set_mode(modes[m]);
+        long long settled = 0, check = 0;
+        t0 = chrono::steady_clock::now();
+        for (size_t q = 0; q < pairs.size(); ++q)
+        {
+            check += loaded.path_size(pairs[q].first, pairs[q].second);
+            settled += loaded.settled();
+        }
+        perQuery[m] = seconds(t0) / queries;
+        cout << setw(16) << names[m] << setw(16) << settled / queries << setw(14) << setprecision(1) << perQuery[m] * 1e6 << setw(18) << check << endl;
+    }
+    if (perQuery[0] > perQuery[1])
+        cout << endl << "Preprocessing pays off after " << static_cast<long long>(build / (perQuery[0] - perQuery[1])) + 1 << " queries" << endl;
+}
+
+// G(n, p) generation with about avgDegree edges per vertex: one draw per pair (the old randomGraph loop)
+// against geometric skipping, then geometric skipping on 1, 2, 4 .. maxThreads threads at numVert vertices.
+// The checksum is the same for every thread count.
+static void benchGnp(int numVert, double avgDegree, unsigned maxThreads)
+{
+    auto seconds = [](chrono::steady_clock::time_point t0)
+    {
+        return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    };
+    auto checksum = [](const vector<WeightedEdge>& edges)
+    {
+        unsigned long long sum = 0;
+        for (size_t e = 0; e < edges.size(); ++e)
+            sum = sum * 31 + edges[e].from * 7919ULL + edges[e].to * 104729ULL + static_cast<unsigned long long>(edges[e].weight);
+        return sum;
+    };
+
+    cout << "G(n, p), average degree " << avgDegree << endl;
+    cout << setw(10) << "vertices" << setw(12) << "edges" << setw(14) << "per pair s" << setw(14) << "skipping s" << endl;
+    for (int n = 1000; n <= 16000; n *= 2)
+    {
+        double p = avgDegree / (n - 1);
+        auto t0 = chrono::steady_clock::now();
+        vector<WeightedEdge> slow;
+        for (int i = 0; i < n; ++i)
+            for (int j = i + 1; j < n; ++j)
+                if (static_cast<double>(rand()) / RAND_MAX < p)
+                    slow.push_back(WeightedEdge{static_cast<uint32_t>(i), static_cast<uint32_t>(j), rand() % 9 + 1});
+        double perPair = seconds(t0);
+        t0 = chrono::steady_clock::now();
+        vector<WeightedEdge> fast = gnpEdges(static_cast<uint32_t>(n), p, 1, 10, 1);
+        cout << setw(10) << n << setw(12) << fast.size() << setw(14) << fixed << setprecision(4) << perPair << setw(14) << seconds(t0) << endl;
+    }
+
+    double p = avgDegree / (numVert - 1);
+    cout << endl << setw(10) << "threads" << setw(12) << "seconds" << setw(16) << "edges/sec" << setw(22) << "checksum" << endl;
+    for (unsigned t = 1; t <= maxThreads; t = t < maxThreads && t * 2 > maxThreads ? maxThreads : t * 2)
+    {
+        auto t0 = chrono::steady_clock::now();
+        vector<WeightedEdge> edges = gnpEdges(static_cast<uint32_t>(numVert), p, 1, 10, 1, t);
+        double sec = seconds(t0);
+        cout << setw(10) << t << setw(12) << setprecision(4) << sec << setw(16) << setprecision(0) << edges.size() / sec
+             << setw(22) << checksum(edges) << endl;
+    }
+}
+
+// Single-source shortest paths on G(numVert, p) with average degree 10 and weights 1..100: sequential
+// Dijkstra against delta-stepping for several bucket widths, then delta-stepping on 1, 2, 4 .. maxThreads threads
+static void benchDelta(int numVert, unsigned maxThreads)
+{
+    auto seconds = [](chrono::steady_clock::time_point t0)
+    {
+        return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    };
+    auto checksum = [](const vector<int32_t>& dist)
+    {
+        long long sum = 0;
+        for (size_t v = 0; v < dist.size(); ++v)
+            if (dist[v] < DistanceMatrix::INF)
+                sum += dist[v];
+        return sum;
+    };
+    CSRGraph g = gnpGraph(static_cast<uint32_t>(numVert), 10.0 / (numVert - 1), 1, 101, 1, 0);
+    cout << "Delta-stepping: " << g.V() << " vertices, " << g.E() << " edges" << endl;
+    vector<int32_t> dist(g.V()), pred(g.V());
+
+    cout << setw(16) << "method" << setw(10) << "threads" << setw(10) << "delta" << setw(10) << "phases" << setw(12) << "seconds" << setw(18) << "checksum" << endl;
+    SSSPScratch scratch;
+    auto t0 = chrono::steady_clock::now();
+    dijkstraRow(g, 0, scratch, dist.data(), pred.data());
+    cout << setw(16) << "dijkstra" << setw(10) << 1 << setw(10) << "-" << setw(10) << "-" << setw(12) << fixed << setprecision(4) << seconds(t0)
+         << setw(18) << checksum(dist) << endl;
+
+    DeltaStepping ds;
+    int widths[] = {0, 10, 25, 50, 100, 400};
+    for (int k = 0; k < 6; ++k)
+    {
+        ds.bind(g, widths[k]);
+        t0 = chrono::steady_clock::now();
+        ds.run(0, maxThreads, dist.data(), pred.data());
+        cout << setw(16) << "delta-stepping" << setw(10) << maxThreads << setw(10) << ds.delta() << setw(10) << ds.phases() << setw(12) << seconds(t0)
+             << setw(18) << checksum(dist) << endl;
+    }
+    ds.bind(g);
+    for (unsigned t = 1; t <= maxThreads; t = t < maxThreads && t * 2 > maxThreads ? maxThreads : t * 2)
+    {
+        t0 = chrono::steady_clock::now();
+        ds.run(0, t, dist.data(), pred.data());
+        cout << setw(16) << "delta-stepping" << setw(10) << t << setw(10) << ds.delta() << setw(10) << ds.phases() << setw(12) << seconds(t0)
+             << setw(18) << checksum(dist) << endl;
+    }
+}
+
+// Weight changes on a side x side grid with 'sources' tracked sources: repairing their trees after each change
+// against recomputing them; afterwards the repaired distances are checked against a fresh Dijkstra run
+static void benchDynamic(int side, int updates, int sources)
+{
+    vector<double> x, y;
+    shared_ptr<CSRGraph> g = make_shared<CSRGraph>(gridGraph(side, x, y));
+    int n = static_cast<int>(g->V());
+    auto seconds = [](chrono::steady_clock::time_point t0)
+    {
+        return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    };
+    cout << "Dynamic shortest paths: " << g->V() << " vertices, " << g->E() << " edges, " << sources << " tracked sources" << endl;
+
+    ShortestPath sp(g);
+    vector<uint32_t> tracked;
+    for (int k = 0; k < sources; ++k)
+    {
+        tracked.push_back(static_cast<uint32_t>(rand() % n));
+        sp.track(static_cast<int>(tracked.back()));
+    }
+    // Random edges get weights 5..39, so they go both up and down from 10..19
+    vector<pair<int,int> > edges;
+    for (int k = 0; k < updates; ++k)
+    {
+        int u = rand() % n;
+        EdgeRange adj = g->neighbors(static_cast<uint32_t>(u));
+        edges.push_back(make_pair(u, static_cast<int>(adj.to[static_cast<size_t>(rand()) % adj.size()])));
+    }
+    vector<int> weights;
+    for (int k = 0; k < updates; ++k)
+        weights.push_back(5 + rand() % 35);
+
+    auto t0 = chrono::steady_clock::now();
+    for (size_t k = 0; k < edges.size(); ++k)
+        sp.set_edge_value(edges[k].first, edges[k].second, weights[k]);
+    double repair = seconds(t0) / updates;
+
+    // Recomputing the tracked trees after each change, on a sample of the changes
+    int sample = min(updates, 50);
+    SSSPScratch scratch;
+    vector<int32_t> dist(g->V());
+    t0 = chrono::steady_clock::now();
+    for (int k = 0; k < sample; ++k)
+        for (size_t t = 0; t < tracked.size(); ++t)
+            dijkstraRow(*g, tracked[t], scratch, dist.data(), NULL);
+    double recompute = seconds(t0) / sample;
+
+    DistanceMatrix fresh = multiSourceDistances(*g, tracked, 1);
+    long long mismatches = 0;
+    for (size_t t = 0; t < tracked.size(); ++t)
+        for (int v = 0; v < n; ++v)
+        {
+            int expect = fresh.at(t, static_cast<uint32_t>(v)) < DistanceMatrix::INF ? fresh.at(t, static_cast<uint32_t>(v)) : INFINIT;
+            if (sp.path_size(static_cast<int>(tracked[t]), v) != expect)
+                ++mismatches;
+        }
+    cout << updates << " changes: repair " << fixed << setprecision(1) << repair * 1e6 << " us/change, recompute "
+         << recompute * 1e6 << " us/change (" << setprecision(0) << recompute / repair << "x), " << mismatches << " mismatches" << endl;
+}
+
+// Splits "a,b,c" into its items
+static vector<string> splitList(const string& list)
+{
+    vector<string> items;
+    stringstream in(list);
+    string item;
+    while (getline(in, item, ','))
+        if (!item.empty())
+            items.push_back(item);
+    return items;
+}
+
+// --batch [vertices] [densities] [weights] [trials] [csv|json] [threads] [--seed N] [--verbose]
+// Lists are comma separated, weight ranges written min:max, e.g. --batch 50,100 0.1,0.2 1:10,1:100 1000 json.
+// Every combination of vertices, density and weight range gets 'trials' random graphs.
+static int runBatchCommand(int argc, char* argv[])
+{
+    vector<string> args;
+    bool verbose = false;
+    uint64_t seed = static_cast<uint64_t>(time(NULL));
+    for (int i = 2; i < argc; ++i)
+    {
+        string a = argv[i];
+        if (a == "--verbose")
+            verbose = true;
+        else if (a == "--seed" && i + 1 < argc)
+            seed = strtoull(argv[++i], NULL, 10);
+        else
+            args.push_back(a);
+    }
+    vector<string> vertices = splitList(args.size() > 0 ? args[0] : "50");
+    vector<string> densities = splitList(args.size() > 1 ? args[1] : "0.2,0.4");
+    vector<string> weights = splitList(args.size() > 2 ? args[2] : "1:10");
+    int trials = args.size() > 3 ? atoi(args[3].c_str()) : 1000;
+    bool json = args.size() > 4 && args[4] == "json";
+    unsigned threads = args.size() > 5 ? static_cast<unsigned>(atoi(args[5].c_str())) : 0;
+
+    vector<TrialConfig> configs;
+    for (size_t v = 0; v < vertices.size(); ++v)
+        for (size_t d = 0; d < densities.size(); ++d)
+            for (size_t w = 0; w < weights.size(); ++w)
+            {
+                size_t colon = weights[w].find(':');
+                if (colon == string::npos)
+                {
+                    cerr << "Weight range '" << weights[w] << "' is not written min:max" << endl;
+                    return 1;
+                }
+                TrialConfig c = {atoi(vertices[v].c_str()), atof(densities[d].c_str()), atoi(weights[w].substr(0, colon).c_str()),
+                                 atoi(weights[w].substr(colon + 1).c_str()), trials};
+                configs.push_back(c);
+            }
+    MonteCarlo simulation(seed);
+    auto t0 = chrono::steady_clock::now();
+    vector<TrialSummary> summaries = simulation.runBatch(configs, threads, verbose);
+    double sec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    writeSummaries(cout, summaries, json);
+    cerr << configs.size() * static_cast<size_t>(max(trials, 0)) << " trials in " << fixed << setprecision(3) << sec << " s on "
+         << workerCount(threads) << " threads, seed " << seed << endl;
+    return 0;
+}
+
+#ifndef DIJKSTRAS_NO_MAIN
+int main(int argc, char* argv[])
+{
+    // --bench-heaps [maxVertices]: compares the priority queues instead of running the simulations
+    if (argc > 1 && string(argv[1]) == "--bench-heaps")
+    {
+        benchHeaps(argc > 2 ? atoi(argv[2]) : 1000000);
+        return 0;
+    }
+    // --bench-apsp [vertices] [maxThreads]: multi-source / all-pairs throughput as threads are added
+    if (argc > 1 && string(argv[1]) == "--bench-apsp")
+    {
+        benchAPSP(argc > 2 ? atoi(argv[2]) : 100000, workerCount(argc > 3 ? static_cast<unsigned>(atoi(argv[3])) : 0));
+        return 0;
+    }
+    // --bench-p2p [side] [queries]: Dijkstra / bidirectional / A* queries on a side x side grid
+    if (argc > 1 && string(argv[1]) == "--bench-p2p")
+    {
+        benchPointToPoint(argc > 2 ? atoi(argv[2]) : 1000, argc > 3 ? atoi(argv[3]) : 100);
+        return 0;
+    }
+    // --bench-ch [side] [queries]: contraction hierarchy preprocessing against query latency on a side x side grid
+    if (argc > 1 && string(argv[1]) == "--bench-ch")
+    {
+        benchHierarchy(argc > 2 ? atoi(argv[2]) : 200, argc > 3 ? atoi(argv[3]) : 1000);
+        return 0;
+    }
+    // --batch ...: many simulations at once, summarized as CSV or JSON (see runBatchCommand)
+    if (argc > 1 && string(argv[1]) == "--batch")
+        return runBatchCommand(argc, argv);
+    // --bench-dynamic [side] [changes] [sources]: repairing shortest path trees after weight changes against recomputing them
+    if (argc > 1 && string(argv[1]) == "--bench-dynamic")
+    {
+        benchDynamic(argc > 2 ? atoi(argv[2]) : 300, argc > 3 ? atoi(argv[3]) : 10000, argc > 4 ? atoi(argv[4]) : 4);
+        return 0;
+    }
+    // --bench-gnp [vertices] [avgDegree] [maxThreads]: random graph generation, per pair against geometric skipping
+    if (argc > 1 && string(argv[1]) == "--bench-gnp")
+    {
+        benchGnp(argc > 2 ? atoi(argv[2]) : 1000000, argc > 3 ? atof(argv[3]) : 10, workerCount(argc > 4 ? static_cast<unsigned>(atoi(argv[4])) : 0));
+        return 0;
+    }
+    // --bench-delta [vertices] [maxThreads]: parallel delta-stepping against sequential Dijkstra
+    if (argc > 1 && string(argv[1]) == "--bench-delta")
+    {
+        benchDelta(argc > 2 ? atoi(argv[2]) : 1000000, workerCount(argc > 3 ? static_cast<unsigned>(atoi(argv[3])) : 0));
+        return 0;
+    }
+
+
+    // --seed N: repeats the simulations of an earlier run
+    MonteCarlo simulation = argc > 2 && string(argv[1]) == "--seed" ? MonteCarlo(strtoull(argv[2], NULL, 10)) : MonteCarlo();
     Graph g;
 
     //What we learned?
@@ -606,6 +1673,8 @@ int main()
             "and deep copy that allocates memory for the copy and then copies the actual value so that the copy lives in distinct "
             "memory from the source.  " << endl;
 
+    cout << endl << "Random seed: " << simulation.seed() << endl;
+
     // Question: Create a graph with 50 nodes / density 20% and then run simulation
     g = simulation.randomGraph(50,0.2,1,10);
     simulation.run(g);
@@ -617,3 +1686,4 @@ int main()
     return 0;
 }
 
+#endif // DIJKSTRAS_NO_MAIN
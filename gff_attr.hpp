@@ -0,0 +1,255 @@
+#ifndef GFF_ATTR_HPP
+#define GFF_ATTR_HPP
+
+#include "gff_entry.hpp"
+#include "gff_view.hpp"
+#include "gff_table.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+using namespace std;
+
+// Attribute queries: predicates on column 9 ("gene_biotype=protein_coding", "Parent=gene:X").
+// Predicates are evaluated on the raw attribute text of a record, so rejected records never get
+// a tag map; AttrIndex answers repeated lookups on one key from an inverted index instead.
+//
+// A value matches v if it equals v or if one of its comma-separated items does (GFF3 multi-value
+// attributes such as "Parent=tx1,tx2"). As in GFFEntry::tags, the last duplicate of a key counts.
+
+// Value of key in a raw attribute column; false if the record does not have it
+inline bool findAttribute(string_view attrs, string_view key, string_view& value)
+{
+    bool found = false;
+    forEachAttribute(attrs, [&](string_view k, string_view v)
+    {
+        if (k == key)
+        {
+            value = v;
+            found = true;
+        }
+    });
+    return found;
+}
+
+// Calls visit(item) for each comma-separated item of a value
+template <class Visitor>
+void forEachValueItem(string_view value, Visitor&& visit)
+{
+    while (true)
+    {
+        size_t comma = value.find(',');
+        visit(value.substr(0, comma));
+        if (comma == string_view::npos)
+            return;
+        value.remove_prefix(comma + 1);
+    }
+}
+
+// AttrPredicate: one condition on one attribute
+struct AttrPredicate {
+    enum Op { Equals, Contains, InSet };
+
+    string key;
+    Op op = Equals;
+    vector<string> values;	// one for Equals / Contains, any number for InSet
+
+    bool test(string_view value) const;
+};
+
+inline bool AttrPredicate::test(string_view value) const
+{
+    if (op == Contains)
+        return value.find(values[0]) != string_view::npos;
+    auto listed = [this](string_view v) { return find(values.begin(), values.end(), v) != values.end(); };
+    if (listed(value))
+        return true;
+    bool hit = false;
+    if (value.find(',') != string_view::npos)
+        forEachValueItem(value, [&](string_view item) { hit = hit || listed(item); });
+    return hit;
+}
+
+// Parses "key=value" (equals), "key~text" (contains) or "key=v1|v2|v3" (in set); false if malformed
+inline bool parseAttrPredicate(string_view text, AttrPredicate& p)
+{
+    size_t op = text.find_first_of("=~");
+    if (op == 0 || op == string_view::npos || op + 1 == text.size())
+        return false;
+    p.key = string(text.substr(0, op));
+    p.values.clear();
+    string_view rest = text.substr(op + 1);
+    if (text[op] == '~')
+    {
+        p.op = AttrPredicate::Contains;
+        p.values.emplace_back(rest);
+        return true;
+    }
+    for (size_t bar; (bar = rest.find('|')) != string_view::npos; rest.remove_prefix(bar + 1))
+        p.values.emplace_back(rest.substr(0, bar));
+    p.values.emplace_back(rest);
+    p.op = p.values.size() == 1 ? AttrPredicate::Equals : AttrPredicate::InSet;
+    return true;
+}
+
+// AttrFilter: conjunction of predicates, checked in the order they were added
+class AttrFilter
+{
+public:
+    void add(const AttrPredicate& p) { preds.push_back(p); }
+    bool empty() const { return preds.empty(); }
+    const vector<AttrPredicate>& predicates() const { return preds; }
+
+    // Raw attribute column (GFFView::attributes): stops at the first failing predicate
+    bool matches(string_view attrs) const
+    {
+        string_view value;
+        for (const auto& p : preds)
+            if (!findAttribute(attrs, p.key, value) || !p.test(value))
+                return false;
+        return true;
+    }
+    bool matches(const GFFEntry& e) const
+    {
+        for (const auto& p : preds)
+        {
+            auto it = e.tags.find(p.key);
+            if (it == e.tags.end() || !p.test(it->second))
+                return false;
+        }
+        return true;
+    }
+    bool matches(const GFFTable& table, size_t r) const
+    {
+        for (const auto& p : preds)
+        {
+            string_view value = table.attribute(r, p.key);
+            if (value.empty() || !p.test(value))
+                return false;
+        }
+        return true;
+    }
+
+private:
+    vector<AttrPredicate> preds;
+};
+
+// Calls visit(const GFFView&) for the records of a GFF3 buffer that pass the filter
+template <class Visitor>
+void scanGFFWhere(string_view data, const AttrFilter& filter, Visitor&& visit)
+{
+    scanGFF(data, [&](const GFFView& v)
+    {
+        if (filter.matches(v.attributes))
+            visit(v);
+    });
+}
+
+// readGFF() restricted to the records passing the filter: entries are only built for those
+inline vector<GFFEntry> readGFFWhere(const string& filename, const AttrFilter& filter)
+{
+    vector<GFFEntry> data;
+    MappedFile file(filename);
+    scanGFFWhere(file.view(), filter, [&data](const GFFView& v) { data.push_back(toGFFEntry(v)); });
+    return data;
+}
+
+// AttrIndex: inverted index of one attribute key of a GFFTable, value -> record ids.
+// Record ids of value i are records[offsets[i] .. offsets[i+1]) in ascending order (CSR layout);
+// each item of a comma-separated value is indexed as well. Values are views into the table,
+// which must outlive the index.
+class AttrIndex
+{
+public:
+    void build(const GFFTable& table, string_view key);
+    const string& key() const { return indexedKey; }
+    size_t valueCount() const { return valueNames.size(); }
+
+    // Records whose value of the key equals value or lists it
+    vector<uint32_t> lookup(string_view value) const;
+    // Records passing p (p.key must be the indexed key); Contains scans the distinct values only
+    vector<uint32_t> lookup(const AttrPredicate& p) const;
+
+private:
+    string indexedKey;
+    unordered_map<string_view, uint32_t> valueIds;
+    vector<string_view> valueNames;
+    vector<uint32_t> offsets{0};
+    vector<uint32_t> records;
+};
+
+inline void AttrIndex::build(const GFFTable& table, string_view key)
+{
+    indexedKey = string(key);
+    valueIds.clear();
+    valueNames.clear();
+    // (value id, record) pairs in record order, then a counting sort by value id
+    vector<pair<uint32_t, uint32_t>> pairs;
+    int64_t code = table.keys.find(key);
+    auto idOf = [this](string_view v)
+    {
+        auto it = valueIds.emplace(v, static_cast<uint32_t>(valueNames.size())).first;
+        if (it->second == valueNames.size())
+            valueNames.push_back(v);
+        return it->second;
+    };
+    for (size_t r = 0; code >= 0 && r < table.size(); ++r)
+        for (uint64_t a = table.attrBegin[r]; a < table.attrBegin[r + 1]; ++a)
+        {
+            if (table.attrs[a].key != code)
+                continue;
+            string_view value(table.values.data() + table.attrs[a].offset, table.attrs[a].length);
+            uint32_t rec = static_cast<uint32_t>(r);
+            size_t first = pairs.size();
+            pairs.emplace_back(idOf(value), rec);
+            if (value.find(',') == string_view::npos)
+                continue;
+            forEachValueItem(value, [&](string_view item) { pairs.emplace_back(idOf(item), rec); });
+            // "a,a" lists the record under "a" once
+            sort(pairs.begin() + static_cast<ptrdiff_t>(first), pairs.end());
+            pairs.erase(unique(pairs.begin() + static_cast<ptrdiff_t>(first), pairs.end()), pairs.end());
+        }
+
+    // Stable counting sort keeps each value's records in ascending order
+    offsets.assign(valueNames.size() + 1, 0);
+    for (const auto& p : pairs)
+        ++offsets[p.first + 1];
+    for (size_t i = 1; i < offsets.size(); ++i)
+        offsets[i] += offsets[i - 1];
+    records.resize(pairs.size());
+    vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (const auto& p : pairs)
+        records[fill[p.first]++] = p.second;
+}
+
+inline vector<uint32_t> AttrIndex::lookup(string_view value) const
+{
+    auto it = valueIds.find(value);
+    if (it == valueIds.end())
+        return vector<uint32_t>();
+    return vector<uint32_t>(records.begin() + offsets[it->second], records.begin() + offsets[it->second + 1]);
+}
+
+inline vector<uint32_t> AttrIndex::lookup(const AttrPredicate& p) const
+{
+    vector<uint32_t> out;
+    auto add = [&](size_t i) { out.insert(out.end(), records.begin() + offsets[i], records.begin() + offsets[i + 1]); };
+    if (p.op == AttrPredicate::Contains)
+    {
+        for (size_t i = 0; i < valueNames.size(); ++i)
+            if (valueNames[i].find(p.values[0]) != string_view::npos)
+                add(i);
+    }
+    else
+        for (const auto& v : p.values)
+        {
+            auto it = valueIds.find(v);
+            if (it != valueIds.end())
+                add(it->second);
+        }
+    sort(out.begin(), out.end());
+    out.erase(unique(out.begin(), out.end()), out.end());
+    return out;
+}
+
+#endif // GFF_ATTR_HPP
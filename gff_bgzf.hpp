@@ -0,0 +1,573 @@
+#ifndef GFF_BGZF_HPP
+#define GFF_BGZF_HPP
+
+#include "gff_entry.hpp"
+#include "gff_view.hpp"
+#include "gff_stream.hpp"
+#include "gff_parallel.hpp"
+#include "gff_table.hpp"
+
+#include <functional>
+#include <streambuf>
+#include <unordered_map>
+#include <zlib.h>
+
+using namespace std;
+
+// Compressed GFF3 input (.gff3.gz).
+//  - Plain gzip is inflated as a stream (GzipStreamBuf), so any istream based reader works.
+//  - BGZF (blocked gzip, as written by bgzip) is a series of independent gzip members of at
+//    most 64 KiB; those blocks are inflated in parallel and handed to the parser in order.
+//  - With a tabix (.tbi) or CSI (.csi) index next to a BGZF file, a region query inflates only
+//    the blocks the index points at instead of the whole file.
+
+// Returns true if the file starts with the gzip magic bytes (plain gzip or BGZF)
+inline bool isGzipFile(const string& filename)
+{
+    ifstream in(filename, ios::binary);
+    unsigned char magic[2] = {0, 0};
+    in.read(reinterpret_cast<char*>(magic), 2);
+    return in && magic[0] == 0x1f && magic[1] == 0x8b;
+}
+
+// Little-endian readers for the gzip header and the index files
+inline uint16_t readLE16(const unsigned char* p)
+{
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+inline uint32_t readLE32(const unsigned char* p)
+{
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 | static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+// GzipStreamBuf: read-only stream buffer that inflates a gzip file on the fly.
+// Every member of a multi-member file (e.g. every BGZF block) is read in turn.
+class GzipStreamBuf : public streambuf
+{
+public:
+    explicit GzipStreamBuf(const string& filename, size_t bufferSize = 1 << 18)
+        : in(filename, ios::binary), inBuf(bufferSize), outBuf(bufferSize)
+    {
+        memset(&zs, 0, sizeof(zs));
+        // 15 + 32: maximum window, gzip or zlib header detected automatically
+        ok = in.is_open() && inflateInit2(&zs, 15 + 32) == Z_OK;
+    }
+    GzipStreamBuf(const GzipStreamBuf&) = delete;
+    GzipStreamBuf& operator=(const GzipStreamBuf&) = delete;
+    ~GzipStreamBuf() override { inflateEnd(&zs); }
+
+    bool is_open() const { return ok; }
+    // Corrupt or truncated data was met; reading stopped there
+    bool failed() const { return damaged; }
+
+protected:
+    int_type underflow() override;
+
+private:
+    ifstream in;
+    z_stream zs;
+    vector<char> inBuf, outBuf;
+    bool ok = false;
+    bool damaged = false;
+    bool inMember = false;	// input ended inside a gzip member if still set at end of file
+};
+
+inline GzipStreamBuf::int_type GzipStreamBuf::underflow()
+{
+    if (gptr() < egptr())
+        return traits_type::to_int_type(*gptr());
+    while (ok)
+    {
+        if (zs.avail_in == 0)
+        {
+            in.read(inBuf.data(), static_cast<streamsize>(inBuf.size()));
+            zs.avail_in = static_cast<uInt>(in.gcount());
+            zs.next_in = reinterpret_cast<Bytef*>(inBuf.data());
+            if (zs.avail_in == 0)
+            {
+                damaged = damaged || inMember;
+                break;
+            }
+        }
+        zs.next_out = reinterpret_cast<Bytef*>(outBuf.data());
+        zs.avail_out = static_cast<uInt>(outBuf.size());
+        int ret = inflate(&zs, Z_NO_FLUSH);
+        size_t produced = outBuf.size() - zs.avail_out;
+        inMember = ret != Z_STREAM_END;
+        if (ret == Z_STREAM_END)
+            inflateReset(&zs);		// next member, if any
+        else if (ret != Z_OK && ret != Z_BUF_ERROR)
+        {
+            ok = false;			// corrupt data: stop at what was inflated so far
+            damaged = true;
+        }
+        if (produced > 0)
+        {
+            setg(outBuf.data(), outBuf.data(), outBuf.data() + produced);
+            return traits_type::to_int_type(*gptr());
+        }
+    }
+    return traits_type::eof();
+}
+
+// BGZFBlock: position of one BGZF block in the compressed file
+struct BGZFBlock {
+    uint64_t offset;	// file offset of the block
+    uint32_t size;	// compressed size of the whole block (BSIZE + 1)
+    uint32_t usize;	// inflated size (ISIZE)
+};
+
+// Reads the BGZF block header at offset; false if there is no valid BGZF block there
+inline bool bgzfBlockAt(string_view data, uint64_t offset, BGZFBlock& b)
+{
+    if (offset + 18 > data.size())
+        return false;
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data.data() + offset);
+    // gzip magic, deflate, FEXTRA set
+    if (p[0] != 0x1f || p[1] != 0x8b || p[2] != 8 || (p[3] & 4) == 0)
+        return false;
+    uint16_t xlen = readLE16(p + 10);
+    if (offset + 12 + xlen > data.size())
+        return false;
+    // The 'BC' extra subfield holds the block size minus one
+    for (uint32_t x = 12; x + 4 <= 12u + xlen; x += 4u + readLE16(p + x + 2))
+        if (p[x] == 'B' && p[x + 1] == 'C' && readLE16(p + x + 2) == 2)
+        {
+            b.offset = offset;
+            b.size = static_cast<uint32_t>(readLE16(p + x + 4)) + 1;
+            if (b.size < 12u + xlen + 8 || offset + b.size > data.size())
+                return false;
+            b.usize = readLE32(p + b.size - 4);
+            return true;
+        }
+    return false;
+}
+
+// Lists the blocks of a BGZF file; empty if the data is not (entirely) BGZF
+inline vector<BGZFBlock> bgzfBlocks(string_view data)
+{
+    vector<BGZFBlock> blocks;
+    BGZFBlock b;
+    for (uint64_t off = 0; off < data.size(); off += b.size)
+    {
+        if (!bgzfBlockAt(data, off, b))
+            return vector<BGZFBlock>();
+        blocks.push_back(b);
+    }
+    return blocks;
+}
+
+// Inflates one block into out (b.usize bytes) and checks its CRC
+inline bool inflateBGZFBlock(string_view data, const BGZFBlock& b, char* out)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data.data() + b.offset);
+    uint32_t header = 12u + readLE16(p + 10);
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (inflateInit2(&zs, -15) != Z_OK)	// raw deflate: the gzip header was parsed above
+        return false;
+    zs.next_in = const_cast<Bytef*>(p + header);
+    zs.avail_in = b.size - header - 8;
+    zs.next_out = reinterpret_cast<Bytef*>(out);
+    zs.avail_out = b.usize;
+    int ret = inflate(&zs, Z_FINISH);
+    bool good = ret == Z_STREAM_END && zs.total_out == b.usize;
+    inflateEnd(&zs);
+    return good && crc32(0, reinterpret_cast<const Bytef*>(out), b.usize) == readLE32(p + b.size - 8);
+}
+
+// Inflates blocks on 'threads' threads, a batch at a time, and passes each batch of text to
+// consume(string_view) in file order. Returns false on a corrupt block.
+// With more than one thread inflating and consuming overlap: while consume() works on one batch
+// on the calling thread, the next batch is inflated on the other threads.
+template <class Consume>
+bool inflateBGZF(string_view data, const vector<BGZFBlock>& blocks, unsigned threads, Consume&& consume)
+{
+    threads = threadCount(threads);
+    // About 4 MiB of output per thread per batch
+    const size_t batch = size_t(threads) * 64;
+    struct Batch {
+        vector<char> text;
+        vector<size_t> offset;
+        bool good = true;
+    };
+    auto inflateBatch = [&](size_t b0, unsigned workers, Batch& out)
+    {
+        size_t b1 = min(blocks.size(), b0 + batch);
+        out.offset.assign(1, 0);
+        for (size_t b = b0; b < b1; ++b)
+            out.offset.push_back(out.offset.back() + blocks[b].usize);
+        out.text.resize(out.offset.back());
+        atomic<bool> good(true);
+        runParallel(workers, b1 - b0, [&](size_t i)
+        {
+            if (!inflateBGZFBlock(data, blocks[b0 + i], out.text.data() + out.offset[i]))
+                good = false;
+        });
+        out.good = good;
+    };
+
+    Batch current, next;
+    if (!blocks.empty())
+        inflateBatch(0, threads, current);
+    for (size_t b0 = 0; b0 < blocks.size(); b0 += batch)
+    {
+        if (!current.good)
+            return false;
+        thread ahead;
+        if (b0 + batch < blocks.size())
+        {
+            if (threads > 1)
+                ahead = thread(inflateBatch, b0 + batch, threads - 1, ref(next));
+            else
+                inflateBatch(b0 + batch, 1, next);
+        }
+        try
+        {
+            consume(string_view(current.text.data(), current.text.size()));
+        }
+        catch (...)
+        {
+            if (ahead.joinable())
+                ahead.join();
+            throw;
+        }
+        if (ahead.joinable())
+            ahead.join();
+        swap(current, next);
+    }
+    return true;
+}
+
+// GFFLineJoiner: turns successive pieces of text into runs of whole lines.
+// Lines split across pieces are carried over to the next call.
+class GFFLineJoiner
+{
+public:
+    // Calls lines(string_view) with every complete line contained in text (plus the carried part)
+    template <class Lines>
+    void feed(string_view text, Lines&& lines)
+    {
+        if (!carry.empty())
+        {
+            size_t nl = text.find('\n');
+            carry.append(text.substr(0, nl == string_view::npos ? text.size() : nl + 1));
+            if (nl == string_view::npos)
+                return;
+            lines(string_view(carry));
+            carry.clear();
+            text.remove_prefix(nl + 1);
+        }
+        size_t last = text.rfind('\n');
+        if (last == string_view::npos)
+        {
+            carry.assign(text);
+            return;
+        }
+        lines(text.substr(0, last + 1));
+        carry.assign(text.substr(last + 1));
+    }
+    // Hands over a last line that had no trailing '\n'
+    template <class Lines>
+    void finish(Lines&& lines)
+    {
+        if (!carry.empty())
+            lines(string_view(carry));
+        carry.clear();
+    }
+
+private:
+    string carry;
+};
+
+// Calls lines(string_view) with the whole inflated content of a gzip or BGZF file, in runs of complete lines.
+// BGZF blocks are inflated on 'threads' threads. Returns false if the file cannot be read or is corrupt or truncated.
+template <class Lines>
+bool inflateGFFLines(const string& filename, unsigned threads, Lines&& lines)
+{
+    GFFLineJoiner joiner;
+    MappedFile file(filename);
+    if (!file.is_open())
+        return false;
+    vector<BGZFBlock> blocks = bgzfBlocks(file.view());
+    if (!blocks.empty())
+    {
+        if (!inflateBGZF(file.view(), blocks, threads, [&](string_view text) { joiner.feed(text, lines); }))
+            return false;
+    }
+    else
+    {
+        // Plain gzip: one stream, inflated sequentially
+        GzipStreamBuf buf(filename);
+        if (!buf.is_open())
+            return false;
+        istream in(&buf);
+        vector<char> piece(1 << 20);
+        while (in.read(piece.data(), static_cast<streamsize>(piece.size())) || in.gcount() > 0)
+            joiner.feed(string_view(piece.data(), static_cast<size_t>(in.gcount())), lines);
+        if (buf.failed())
+            return false;
+    }
+    joiner.finish(lines);
+    return true;
+}
+
+// Compressed counterpart of readGFFTable(); false if the file cannot be opened or inflated
+// (table then holds the records read before the error)
+inline bool readGFFTableCompressed(const string& filename, unsigned threads, GFFTable& table)
+{
+    table = GFFTable();
+    return inflateGFFLines(filename, threads, [&table](string_view text)
+    {
+        scanGFF(text, [&table](const GFFView& v) { table.append(v); });
+    });
+}
+
+// Compressed counterpart of readGFF(); false if the file cannot be opened or inflated
+inline bool readGFFCompressed(const string& filename, unsigned threads, vector<GFFEntry>& data)
+{
+    data.clear();
+    return inflateGFFLines(filename, threads, [&data](string_view text)
+    {
+        scanGFF(text, [&data](const GFFView& v) { data.push_back(toGFFEntry(v)); });
+    });
+}
+
+// TabixIndex: binning index of a BGZF file, loaded from a tabix (.tbi) or CSI (.csi) file.
+// Maps a region to the BGZF virtual offsets (compressed offset << 16 | offset in block) to read.
+class TabixIndex
+{
+public:
+    // Loads filename.tbi or, failing that, filename.csi
+    bool load(const string& filename);
+    // Merged [begin, end) virtual offset chunks that may hold records overlapping [start, end] (1-based, closed)
+    vector<pair<uint64_t, uint64_t>> chunks(const string& seqid, uint64_t start, uint64_t end) const;
+
+private:
+    struct Bin {
+        uint64_t loffset = 0;	// CSI: smallest virtual offset of records in this bin
+        vector<pair<uint64_t, uint64_t>> chunks;
+    };
+    struct Ref {
+        unordered_map<uint32_t, Bin> bins;
+        vector<uint64_t> linear;	// tabix: smallest virtual offset per 2^minShift window
+    };
+    bool parse(const string& raw, bool csi);
+
+    int minShift = 14;
+    int depth = 5;
+    bool csi = false;
+    unordered_map<string, int> names;
+    vector<Ref> refs;
+};
+
+inline bool TabixIndex::load(const string& filename)
+{
+    for (bool isCsi : {false, true})
+    {
+        string name = filename + (isCsi ? ".csi" : ".tbi");
+        GzipStreamBuf buf(name);
+        if (!buf.is_open())
+            continue;
+        istream in(&buf);
+        string raw((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        if (parse(raw, isCsi))
+            return true;
+    }
+    return false;
+}
+
+// Parses an inflated .tbi or .csi file; every read is bounds-checked
+inline bool TabixIndex::parse(const string& raw, bool isCsi)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(raw.data());
+    size_t pos = 0, size = raw.size();
+    bool good = true;
+    auto need = [&](size_t n) { good = good && pos + n <= size; return good; };
+    auto i32 = [&]() { if (!need(4)) return int32_t(0); int32_t v = static_cast<int32_t>(readLE32(p + pos)); pos += 4; return v; };
+    auto u64 = [&]() { if (!need(8)) return uint64_t(0); uint64_t v = readLE32(p + pos) | static_cast<uint64_t>(readLE32(p + pos + 4)) << 32; pos += 8; return v; };
+
+    csi = isCsi;
+    names.clear();
+    refs.clear();
+    if (!need(4) || memcmp(p, isCsi ? "CSI\1" : "TBI\1", 4) != 0)
+        return false;
+    pos = 4;
+    size_t namesEnd = 0;
+    if (isCsi)
+    {
+        minShift = i32();
+        depth = i32();
+        int32_t lAux = i32();
+        // The aux block holds the tabix header (format, columns, meta, skip, names)
+        if (lAux < 28 || !need(static_cast<size_t>(lAux)))
+            return false;
+        namesEnd = pos + static_cast<size_t>(lAux);
+        pos += 24;
+    }
+    else
+    {
+        minShift = 14;
+        depth = 5;
+    }
+    int32_t nRef = isCsi ? 0 : i32();
+    if (!isCsi)
+        pos += 24;	// format, col_seq, col_beg, col_end, meta, skip
+    int32_t lNm = i32();
+    if (lNm < 0 || !need(static_cast<size_t>(lNm)))
+        return false;
+    // Names are NUL-terminated and concatenated; their order gives the reference ids
+    for (size_t q = pos, end = pos + static_cast<size_t>(lNm); q < end;)
+    {
+        size_t len = strnlen(raw.data() + q, end - q);
+        names.emplace(raw.substr(q, len), static_cast<int>(names.size()));
+        q += len + 1;
+    }
+    pos += static_cast<size_t>(lNm);
+    if (isCsi)
+    {
+        pos = namesEnd;
+        nRef = i32();
+    }
+    if (!good || nRef < 0 || minShift <= 0 || depth <= 0 || depth > 10)
+        return false;
+
+    refs.resize(static_cast<size_t>(nRef));
+    for (auto& ref : refs)
+    {
+        int32_t nBin = i32();
+        for (int32_t b = 0; good && b < nBin; ++b)
+        {
+            uint32_t id = static_cast<uint32_t>(i32());
+            Bin& bin = ref.bins[id];
+            if (isCsi)
+                bin.loffset = u64();
+            int32_t nChunk = i32();
+            for (int32_t c = 0; good && c < nChunk; ++c)
+            {
+                uint64_t beg = u64();
+                uint64_t end = u64();
+                bin.chunks.emplace_back(beg, end);
+            }
+        }
+        if (!isCsi)
+        {
+            int32_t nIntv = i32();
+            for (int32_t i = 0; good && i < nIntv; ++i)
+                ref.linear.push_back(u64());
+        }
+    }
+    return good;
+}
+
+inline vector<pair<uint64_t, uint64_t>> TabixIndex::chunks(const string& seqid, uint64_t start, uint64_t end) const
+{
+    vector<pair<uint64_t, uint64_t>> out;
+    auto it = names.find(seqid);
+    if (it == names.end() || static_cast<size_t>(it->second) >= refs.size() || end < start)
+        return out;
+    const Ref& ref = refs[static_cast<size_t>(it->second)];
+    // Index coordinates are 0-based, half-open
+    uint64_t beg = start > 0 ? start - 1 : 0, last = end > 0 ? end - 1 : 0;
+
+    // Lowest offset a record overlapping beg can start at
+    uint64_t minOff = 0;
+    if (!csi && !ref.linear.empty())
+        minOff = ref.linear[min(static_cast<size_t>(beg >> minShift), ref.linear.size() - 1)];
+    else if (csi)
+    {
+        // The deepest existing bin that contains beg knows the smallest offset
+        for (int l = depth; l >= 0; --l)
+        {
+            uint64_t first = ((uint64_t(1) << (3 * l)) - 1) / 7;
+            auto bin = ref.bins.find(static_cast<uint32_t>(first + (beg >> (minShift + 3 * (depth - l)))));
+            if (bin != ref.bins.end())
+            {
+                minOff = bin->second.loffset;
+                break;
+            }
+        }
+    }
+
+    // Every bin overlapping [beg, last], level by level (reg2bins)
+    for (int l = 0; l <= depth; ++l)
+    {
+        uint64_t first = ((uint64_t(1) << (3 * l)) - 1) / 7;
+        int shift = minShift + 3 * (depth - l);
+        for (uint64_t b = first + (beg >> shift); b <= first + (last >> shift); ++b)
+        {
+            auto bin = ref.bins.find(static_cast<uint32_t>(b));
+            if (bin == ref.bins.end())
+                continue;
+            for (const auto& c : bin->second.chunks)
+                if (c.second > minOff)
+                    out.push_back(c);
+        }
+    }
+
+    // Sorts and merges overlapping chunks so no block is read twice
+    sort(out.begin(), out.end());
+    vector<pair<uint64_t, uint64_t>> merged;
+    for (const auto& c : out)
+    {
+        if (!merged.empty() && c.first <= merged.back().second)
+            merged.back().second = max(merged.back().second, c.second);
+        else
+            merged.push_back(c);
+    }
+    return merged;
+}
+
+// Region query on a BGZF file through its index: only the blocks of the matching chunks are
+// inflated (on 'threads' threads); visit(const GFFView&) is called for records inside region.
+template <class Visitor>
+bool queryBGZF(const MappedFile& file, const TabixIndex& index, const GFFRegion& region, unsigned threads, Visitor&& visit)
+{
+    string text;
+    for (const auto& c : index.chunks(region.seqid, region.start, region.end))
+    {
+        // Blocks from the one holding the chunk start to the one holding its end
+        vector<BGZFBlock> blocks;
+        BGZFBlock b;
+        for (uint64_t off = c.first >> 16; off <= (c.second >> 16) && off < file.size(); off += b.size)
+        {
+            if (!bgzfBlockAt(file.view(), off, b))
+                return false;
+            blocks.push_back(b);
+        }
+        if (blocks.empty())
+            continue;
+        text.clear();
+        if (!inflateBGZF(file.view(), blocks, threads, [&text](string_view t) { text.append(t); }))
+            return false;
+        // Trims to [begin, end) of the chunk: offsets within the first and last block
+        size_t from = min(text.size(), static_cast<size_t>(c.first & 0xffff));
+        size_t to = text.size();
+        if (blocks.back().offset == (c.second >> 16))
+            to = text.size() - blocks.back().usize + static_cast<size_t>(c.second & 0xffff);
+        if (to > from)
+            scanGFFRegion(string_view(text).substr(from, to - from), region, visit);
+    }
+    return true;
+}
+
+// Region query on a compressed file: through the .tbi/.csi index when the file is BGZF and
+// indexed, otherwise by inflating the whole file and filtering while parsing.
+template <class Visitor>
+bool scanCompressedRegion(const string& filename, const GFFRegion& region, unsigned threads, Visitor&& visit)
+{
+    MappedFile file(filename);
+    if (!file.is_open())
+        return false;
+    TabixIndex index;
+    BGZFBlock first;
+    if (bgzfBlockAt(file.view(), 0, first) && index.load(filename))
+        return queryBGZF(file, index, region, threads, visit);
+    return inflateGFFLines(filename, threads, [&](string_view text)
+    {
+        scanGFFRegion(text, region, visit);
+    });
+}
+
+#endif // GFF_BGZF_HPP
@@ -0,0 +1,351 @@
+#ifndef GFF_CACHE_HPP
+#define GFF_CACHE_HPP
+
+#include "gff_entry.hpp"
+#include "gff_view.hpp"
+#include "gff_index.hpp"
+#include "gff_table.hpp"
+
+#include <cstdio>
+#include <unordered_map>
+
+using namespace std;
+
+// Binary GFF3 cache file (<input>.gffbin), written once and memory-mapped by later runs.
+// Layout: a fixed header followed by 8-byte aligned sections in native byte order:
+//  - seqid/source/type dictionaries (chars + offsets)
+//  - per-record columns: dictionary codes, start, end, score, strand, phase
+//  - attribute blob with per-record offsets
+//  - the GFFIndex interval trees (nodes, per-seqid offsets and root levels)
+// The header records the size and mtime of the source file; a changed source invalidates the cache.
+
+const char GFF_CACHE_MAGIC[8] = {'G', 'F', 'F', 'B', 'I', 'N', '\0', '\0'};
+const uint32_t GFF_CACHE_VERSION = 2;	// 2: attributes in file order
+
+enum GFFCacheSectionId {
+    SeqidChars, SeqidOffsets, SourceChars, SourceOffsets, TypeChars, TypeOffsets,
+    SeqidCol, SourceCol, TypeCol, StartCol, EndCol, ScoreCol, StrandCol, PhaseCol,
+    AttrOffsets, AttrBlob, TreeNodes, TreeOffsets, TreeLevels,
+    GFFCacheSectionCount
+};
+
+struct GFFCacheSection {
+    uint64_t offset;
+    uint64_t size;	// in bytes
+};
+
+struct GFFCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t sectionCount;
+    uint64_t sourceSize;
+    int64_t sourceMtime;	// nanoseconds since the epoch
+    uint64_t records;
+    GFFCacheSection sections[GFFCacheSectionCount];
+};
+
+// Cache file name used for an input file
+inline string cacheFileName(const string& filename)
+{
+    return filename + ".gffbin";
+}
+
+// Writes the cache for the table (and its index) read from the source file filename.
+// The file is written under a temporary name and renamed, so readers never see a partial cache.
+inline bool writeGFFCache(const string& filename, const GFFTable& table, const GFFIndex& index)
+{
+    GFFCacheHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, GFF_CACHE_MAGIC, sizeof(hdr.magic));
+    hdr.version = GFF_CACHE_VERSION;
+    hdr.sectionCount = GFFCacheSectionCount;
+    hdr.records = table.size();
+    if (!fileStamp(filename, hdr.sourceSize, hdr.sourceMtime) || table.size() > UINT32_MAX)
+        return false;
+
+    // Seqid codes are the index's ids, so tree slices and the seqid column agree
+    StringDict seqids;
+    for (size_t s = 0; s < index.seqidCount(); ++s)
+        seqids.intern(index.seqidName(static_cast<int>(s)));
+    vector<uint32_t> seqidCode(table.seqids.size());
+    for (uint32_t c = 0; c < seqidCode.size(); ++c)
+        seqidCode[c] = seqids.intern(table.seqids[c]);
+
+    size_t n = table.size();
+    vector<uint32_t> seqidCol(n);
+    for (size_t r = 0; r < n; ++r)
+        seqidCol[r] = seqidCode[table.seqidCol[r]];
+
+    // The attribute arena is written back as "key=value;..." text, one slice per record
+    vector<uint64_t> attrOffsets{0};
+    vector<char> attrBlob;
+    for (size_t r = 0; r < n; ++r)
+    {
+        for (uint64_t a = table.attrBegin[r]; a < table.attrBegin[r + 1]; ++a)
+        {
+            if (a != table.attrBegin[r])
+                attrBlob.push_back(';');
+            string_view key = table.keys[table.attrs[a].key];
+            attrBlob.insert(attrBlob.end(), key.begin(), key.end());
+            attrBlob.push_back('=');
+            const char* val = table.values.data() + table.attrs[a].offset;
+            attrBlob.insert(attrBlob.end(), val, val + table.attrs[a].length);
+        }
+        attrOffsets.push_back(attrBlob.size());
+    }
+    vector<uint64_t> treeOffsets(index.offsets().begin(), index.offsets().end());
+    vector<int32_t> treeLevels(index.levels().begin(), index.levels().end());
+
+    string tmpName = cacheFileName(filename) + ".tmp";
+    ofstream out(tmpName, ios::binary | ios::trunc);
+    if (!out)
+        return false;
+    out.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+    uint64_t pos = sizeof(hdr);
+    // Appends one section, padded to 8 bytes, and records where it went
+    auto section = [&](GFFCacheSectionId id, const void* data, size_t bytes)
+    {
+        static const char zeros[8] = {};
+        hdr.sections[id] = GFFCacheSection{pos, bytes};
+        out.write(static_cast<const char*>(data), static_cast<streamsize>(bytes));
+        size_t pad = (8 - bytes % 8) % 8;
+        out.write(zeros, static_cast<streamsize>(pad));
+        pos += bytes + pad;
+    };
+    section(SeqidChars, seqids.chars.data(), seqids.chars.size());
+    section(SeqidOffsets, seqids.offsets.data(), seqids.offsets.size() * sizeof(uint64_t));
+    section(SourceChars, table.sources.chars.data(), table.sources.chars.size());
+    section(SourceOffsets, table.sources.offsets.data(), table.sources.offsets.size() * sizeof(uint64_t));
+    section(TypeChars, table.types.chars.data(), table.types.chars.size());
+    section(TypeOffsets, table.types.offsets.data(), table.types.offsets.size() * sizeof(uint64_t));
+    section(SeqidCol, seqidCol.data(), n * sizeof(uint32_t));
+    section(SourceCol, table.sourceCol.data(), n * sizeof(uint32_t));
+    section(TypeCol, table.typeCol.data(), n * sizeof(uint32_t));
+    section(StartCol, table.starts.data(), n * sizeof(uint64_t));
+    section(EndCol, table.ends.data(), n * sizeof(uint64_t));
+    section(ScoreCol, table.scores.data(), n * sizeof(float));
+    section(StrandCol, table.strands.data(), n);
+    section(PhaseCol, table.phases.data(), n);
+    section(AttrOffsets, attrOffsets.data(), attrOffsets.size() * sizeof(uint64_t));
+    section(AttrBlob, attrBlob.data(), attrBlob.size());
+    section(TreeNodes, index.nodes().data(), index.nodes().size() * sizeof(IntervalNode));
+    section(TreeOffsets, treeOffsets.data(), treeOffsets.size() * sizeof(uint64_t));
+    section(TreeLevels, treeLevels.data(), treeLevels.size() * sizeof(int32_t));
+
+    // Rewrites the header now that the section table is known
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+    out.close();
+    if (!out)
+    {
+        remove(tmpName.c_str());
+        return false;
+    }
+    return rename(tmpName.c_str(), cacheFileName(filename).c_str()) == 0;
+}
+
+// GFFCache: memory-mapped cache file; columns and index are used in place without parsing
+class GFFCache
+{
+public:
+    // Maps the cache of the source file filename; returns false if it is missing, corrupt or stale
+    bool open(const string& filename);
+    size_t size() const { return records; }
+
+    string_view seqid(size_t r) const { return dictEntry(SeqidChars, SeqidOffsets, column<uint32_t>(SeqidCol)[r]); }
+    string_view source(size_t r) const { return dictEntry(SourceChars, SourceOffsets, column<uint32_t>(SourceCol)[r]); }
+    string_view type(size_t r) const { return dictEntry(TypeChars, TypeOffsets, column<uint32_t>(TypeCol)[r]); }
+    GFFView view(size_t r) const;
+
+    // Record numbers (in file order) of features inside / overlapping [start, end] on seqid
+    vector<uint32_t> contained(string_view seqid, uint64_t start, uint64_t end) const;
+    vector<uint32_t> overlapping(string_view seqid, uint64_t start, uint64_t end) const;
+
+private:
+    template <class T>
+    const T* column(GFFCacheSectionId id) const
+    {
+        return reinterpret_cast<const T*>(file.data() + hdr->sections[id].offset);
+    }
+    string_view dictEntry(GFFCacheSectionId chars, GFFCacheSectionId offsets, uint32_t code) const
+    {
+        const uint64_t* off = column<uint64_t>(offsets);
+        return string_view(column<char>(chars) + off[code], off[code + 1] - off[code]);
+    }
+    // Section sizes, offsets and codes all in range (run once by open(), before anything is read)
+    bool validate() const;
+    // Offsets section of a dictionary: ascending from 0 to the size of its chars section; returns the
+    // number of strings, or -1 if the offsets are broken
+    int64_t dictSize(GFFCacheSectionId chars, GFFCacheSectionId offsets) const;
+    int seqidId(string_view seqid) const
+    {
+        auto it = seqids.find(seqid);
+        return it == seqids.end() ? -1 : it->second;
+    }
+
+    MappedFile file;
+    const GFFCacheHeader* hdr = nullptr;
+    size_t records = 0;
+    unordered_map<string_view, int> seqids;	// views into the mapped seqid dictionary
+};
+
+inline bool GFFCache::open(const string& filename)
+{
+    uint64_t size;
+    int64_t mtime;
+    seqids.clear();
+    records = 0;
+    if (!fileStamp(filename, size, mtime) || !file.open(cacheFileName(filename)) || file.size() < sizeof(GFFCacheHeader))
+        return false;
+    hdr = reinterpret_cast<const GFFCacheHeader*>(file.data());
+    if (memcmp(hdr->magic, GFF_CACHE_MAGIC, sizeof(hdr->magic)) != 0 || hdr->version != GFF_CACHE_VERSION
+        || hdr->sectionCount != GFFCacheSectionCount || hdr->sourceSize != size || hdr->sourceMtime != mtime)
+    {
+        file.close();
+        return false;
+    }
+    for (const auto& s : hdr->sections)
+        if (s.offset % 8 != 0 || s.offset > file.size() || s.size > file.size() - s.offset)
+        {
+            file.close();
+            return false;
+        }
+    records = hdr->records;
+    if (!validate())
+    {
+        file.close();
+        records = 0;
+        return false;
+    }
+
+    size_t nseq = hdr->sections[TreeLevels].size / sizeof(int32_t);
+    for (size_t s = 0; s < nseq; ++s)
+        seqids.emplace(dictEntry(SeqidChars, SeqidOffsets, static_cast<uint32_t>(s)), static_cast<int>(s));
+    return true;
+}
+
+inline int64_t GFFCache::dictSize(GFFCacheSectionId chars, GFFCacheSectionId offsets) const
+{
+    uint64_t bytes = hdr->sections[offsets].size;
+    if (bytes % sizeof(uint64_t) != 0 || bytes == 0)
+        return -1;
+    size_t n = bytes / sizeof(uint64_t);
+    const uint64_t* off = column<uint64_t>(offsets);
+    if (off[0] != 0 || off[n - 1] != hdr->sections[chars].size)
+        return -1;
+    for (size_t i = 1; i < n; ++i)
+        if (off[i] < off[i - 1])
+            return -1;
+    return static_cast<int64_t>(n - 1);
+}
+
+inline bool GFFCache::validate() const
+{
+    const GFFCacheSection* sec = hdr->sections;
+    // Per-record columns must all hold exactly 'records' values (checked against the file size first,
+    // so the products below cannot overflow)
+    if (records > UINT32_MAX || records > file.size()
+        || sec[StartCol].size != records * sizeof(uint64_t) || sec[EndCol].size != records * sizeof(uint64_t)
+        || sec[SeqidCol].size != records * sizeof(uint32_t) || sec[SourceCol].size != records * sizeof(uint32_t)
+        || sec[TypeCol].size != records * sizeof(uint32_t) || sec[ScoreCol].size != records * sizeof(float)
+        || sec[StrandCol].size != records || sec[PhaseCol].size != records
+        || sec[AttrOffsets].size != (records + 1) * sizeof(uint64_t))
+        return false;
+
+    // Dictionaries, and every record's codes into them
+    int64_t nseqids = dictSize(SeqidChars, SeqidOffsets);
+    int64_t nsources = dictSize(SourceChars, SourceOffsets);
+    int64_t ntypes = dictSize(TypeChars, TypeOffsets);
+    if (nseqids < 0 || nsources < 0 || ntypes < 0)
+        return false;
+    const uint32_t* seqidCol = column<uint32_t>(SeqidCol);
+    const uint32_t* sourceCol = column<uint32_t>(SourceCol);
+    const uint32_t* typeCol = column<uint32_t>(TypeCol);
+    for (size_t r = 0; r < records; ++r)
+        if (seqidCol[r] >= nseqids || sourceCol[r] >= nsources || typeCol[r] >= ntypes)
+            return false;
+
+    // Attribute slices within the blob
+    const uint64_t* attr = column<uint64_t>(AttrOffsets);
+    if (attr[0] != 0 || attr[records] > sec[AttrBlob].size)
+        return false;
+    for (size_t r = 0; r < records; ++r)
+        if (attr[r + 1] < attr[r])
+            return false;
+
+    // Interval trees: one slice of nodes and one root level per seqid of the dictionary, nodes naming records
+    if (sec[TreeNodes].size % sizeof(IntervalNode) != 0 || sec[TreeLevels].size % sizeof(int32_t) != 0)
+        return false;
+    size_t nodes = sec[TreeNodes].size / sizeof(IntervalNode);
+    size_t nseq = sec[TreeLevels].size / sizeof(int32_t);
+    if (nseq > static_cast<uint64_t>(nseqids) || sec[TreeOffsets].size != (nseq + 1) * sizeof(uint64_t))
+        return false;
+    const uint64_t* treeOff = column<uint64_t>(TreeOffsets);
+    const int32_t* levels = column<int32_t>(TreeLevels);
+    if (treeOff[0] != 0 || treeOff[nseq] != nodes)
+        return false;
+    for (size_t s = 0; s < nseq; ++s)
+    {
+        if (treeOff[s + 1] < treeOff[s])
+            return false;
+        // The root level buildIntervalTree() gives a slice of this size: floor(log2(n)), -1 if empty
+        uint64_t n = treeOff[s + 1] - treeOff[s];
+        int level = -1;
+        while (level < 63 && (uint64_t(1) << (level + 1)) <= n)
+            ++level;
+        if (levels[s] != level)
+            return false;
+    }
+    const IntervalNode* node = column<IntervalNode>(TreeNodes);
+    for (size_t i = 0; i < nodes; ++i)
+        if (node[i].record >= records)
+            return false;
+    return true;
+}
+
+// Rebuilds the view of record r; text columns point into the mapping
+inline GFFView GFFCache::view(size_t r) const
+{
+    GFFView v;
+    v.seqid = seqid(r);
+    v.source = source(r);
+    v.type = type(r);
+    v.start = column<uint64_t>(StartCol)[r];
+    v.end = column<uint64_t>(EndCol)[r];
+    v.score = column<float>(ScoreCol)[r];
+    v.strand = column<char>(StrandCol)[r];
+    v.phase = column<uint8_t>(PhaseCol)[r];
+    const uint64_t* off = column<uint64_t>(AttrOffsets);
+    v.attributes = string_view(column<char>(AttrBlob) + off[r], off[r + 1] - off[r]);
+    return v;
+}
+
+inline vector<uint32_t> GFFCache::contained(string_view seqid, uint64_t start, uint64_t end) const
+{
+    vector<uint32_t> out;
+    int id = seqidId(seqid);
+    if (id < 0)
+        return out;
+    const uint64_t* off = column<uint64_t>(TreeOffsets);
+    size_t s = static_cast<size_t>(id);
+    containedIntervalTree(column<IntervalNode>(TreeNodes) + off[s], off[s + 1] - off[s], start, end,
+                          [&out](uint32_t r) { out.push_back(r); });
+    sort(out.begin(), out.end());
+    return out;
+}
+
+inline vector<uint32_t> GFFCache::overlapping(string_view seqid, uint64_t start, uint64_t end) const
+{
+    vector<uint32_t> out;
+    int id = seqidId(seqid);
+    if (id < 0)
+        return out;
+    const uint64_t* off = column<uint64_t>(TreeOffsets);
+    size_t s = static_cast<size_t>(id);
+    overlapIntervalTree(column<IntervalNode>(TreeNodes) + off[s], off[s + 1] - off[s], column<int32_t>(TreeLevels)[s],
+                        start, end, [&out](uint32_t r) { out.push_back(r); });
+    sort(out.begin(), out.end());
+    return out;
+}
+
+#endif // GFF_CACHE_HPP
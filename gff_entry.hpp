@@ -24,8 +24,47 @@ struct GFFEntry {
 	char strand;
 	uint8_t phase;
 	std::map<std::string, std::string> tags;
+	std::vector<std::string> tagOrder;	// keys of tags in file order
 };
 
+// Sets a tag; a repeated key takes the new value and moves to the end, so that tagOrder
+// lists every key once, at its last occurrence in the file
+inline void setTag(GFFEntry& e, const string& key, const string& val)
+{
+    auto it = e.tags.find(key);
+    if (it != e.tags.end())
+    {
+        it->second = val;
+        for (auto k = e.tagOrder.begin(); k != e.tagOrder.end(); ++k)
+            if (*k == key)
+            {
+                e.tagOrder.erase(k);
+                break;
+            }
+    }
+    else
+        e.tags.emplace(key, val);
+    e.tagOrder.push_back(key);
+}
+
+// Calls visit(key, value) for each tag in file order. Entries whose tags were changed without
+// setTag() (tagOrder not naming exactly the keys of tags) are visited in key order.
+template <class Visitor>
+void forEachTag(const GFFEntry& e, Visitor&& visit)
+{
+    bool ordered = e.tagOrder.size() == e.tags.size();
+    for (size_t k = 0; ordered && k < e.tagOrder.size(); ++k)
+        ordered = e.tags.find(e.tagOrder[k]) != e.tags.end();
+    if (ordered)
+    {
+        for (const auto& key : e.tagOrder)
+            visit(key, e.tags.find(key)->second);
+        return;
+    }
+    for (const auto& t : e.tags)
+        visit(t.first, t.second);
+}
+
 // Checks for empty '.' and replaces with ""
 void checkDelim(string d)
 {
@@ -42,6 +81,25 @@ float checkDelimf(string d)
     {
         return 0.0;
     }
+    else
+    {
+        return strtof(d.c_str(), nullptr);
+    }
+}
+
+// Fast decimal parser for unsigned fields: no locale, base detection or exceptions.
+// Stops at the first non-digit; an empty range gives 0.
+inline uint64_t parseDecimal(const char* p, const char* e)
+{
+    uint64_t v = 0;
+    for (; p != e; ++p)
+    {
+        unsigned digit = static_cast<unsigned>(static_cast<unsigned char>(*p) - '0');
+        if (digit > 9)
+            break;
+        v = v * 10 + digit;
+    }
+    return v;
 }
 
 // Checks for empty '.' and replaces with uint64_t value 0
@@ -53,7 +111,7 @@ uint64_t checkDelim64(string d)
     }
     else
     {
-        return strtoull(d.c_str(), nullptr, 0);
+        return parseDecimal(d.data(), d.data() + d.size());
     }
 }
 
@@ -66,7 +124,7 @@ uint8_t checkDelim8(string d)
     }
     else
     {
-        return static_cast<uint8_t>(stoi(d));
+        return static_cast<uint8_t>(parseDecimal(d.data(), d.data() + d.size()));
     }
 }
 
@@ -176,7 +234,7 @@ vector<GFFEntry> readGFF(const string& filename)
             istringstream is(d);
             while((getline(is, d, '=') && getline(is,val)))
             {
-                each.tags[d] = val;
+                setTag(each, d, val);
             }
         }
         data.push_back(each);
@@ -184,37 +242,41 @@ vector<GFFEntry> readGFF(const string& filename)
     return data;
 }
 
-// Takes the data from readGFF and couts query seq_id data-points in closed interval of start and end.
+// Writes one entry as a GFF3 line.
 // Every attribute of GFF3 is printed after it's checked for empty values.
-void writeGFF(const vector<GFFEntry>& entries, ostream& out_stream, string seqid, int start, int end)
+void writeEntry(ostream& out_stream, const GFFEntry& each)
 {
     string a;
+    rcheckDelim(each.source);
+    out_stream << each.seqid << '\t' << each.source <<'\t';
+    rcheckDelim(each.type);
+    out_stream << each.type <<'\t';
+    a = writeCheck64(each.start);
+    out_stream << a <<'\t';
+    a = writeCheck64(each.end);
+    out_stream << a <<'\t';
+    a = writeCheckf(each.score);
+    out_stream << a <<'\t' << each.strand <<'\t';
+    a = writeCheck8(each.phase);
+    out_stream << a <<'\t';
+    auto stop = true;
+    // prints attributes with ';'
+    forEachTag(each, [&](const string& key, const string& val)
+    {
+        if(stop) stop = false; else out_stream << ';';
+        out_stream << key << '=' << val;
+    });
+    out_stream << '\n';
+}
+
+// Takes the data from readGFF and couts query seq_id data-points in closed interval of start and end.
+void writeGFF(const vector<GFFEntry>& entries, ostream& out_stream, string seqid, int start, int end)
+{
     for(const auto& i : entries)
     {
         if(i.seqid == seqid && i.start >= start && i.end <= end)
         {
-            GFFEntry each = i;
-            rcheckDelim(each.source);
-            out_stream << each.seqid << '\t' << each.source <<'\t';
-            rcheckDelim(each.type);
-            out_stream << each.type <<'\t';
-            a = writeCheck64(each.start);
-            out_stream << a <<'\t';
-            a = writeCheck64(each.end);
-            out_stream << a <<'\t';
-            a = writeCheckf(each.score);
-            out_stream << a <<'\t' << each.strand <<'\t';
-            a = writeCheck8(each.phase);
-            out_stream << a <<'\t';
-            a = "";
-            auto stop = true;
-            // prints attributes with ';'
-            for(const auto& j : each.tags)
-            {
-                if(stop) stop = false; else out_stream << ';';
-                out_stream << j.first << '=' << j.second;
-            }
-            out_stream << '\n';
+            writeEntry(out_stream, i);
         }
 
     }
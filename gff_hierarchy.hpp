@@ -0,0 +1,285 @@
+#ifndef GFF_HIERARCHY_HPP
+#define GFF_HIERARCHY_HPP
+
+#include "gff_entry.hpp"
+#include "gff_table.hpp"
+#include "gff_attr.hpp"
+
+#include <algorithm>
+#include <unordered_set>
+
+using namespace std;
+
+// RecordRange: read-only run of record ids inside one of the CSR arrays below
+struct RecordRange {
+    const uint32_t* first;
+    const uint32_t* last;
+
+    const uint32_t* begin() const { return first; }
+    const uint32_t* end() const { return last; }
+    size_t size() const { return static_cast<size_t>(last - first); }
+    bool empty() const { return first == last; }
+};
+
+// GFFHierarchy: feature graph built from the ID and Parent attributes in one pass over the records.
+// IDs are interned to integer codes; all edges live in CSR arrays:
+//   records carrying ID code c:      idRecords[idBegin[c] .. idBegin[c+1])
+//   child records of ID code c:      childRecords[childBegin[c] .. childBegin[c+1])
+//   parent ID codes of record r:     parentIds[parentBegin[r] .. parentBegin[r+1])
+// so children are an O(1) lookup. Several records may share an ID (e.g. the lines of a split CDS)
+// and Parent may list several IDs ("Parent=tx1,tx2"); a Parent naming no ID in the file is counted
+// in missingParents() and ignored. Traversals keep a visited set, so cyclic input terminates.
+class GFFHierarchy
+{
+public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    void build(const vector<GFFEntry>& entries);
+    void build(const GFFTable& table);
+    // Generic form: id(r) and parent(r) return the ID and Parent values of record r ("" if absent)
+    template <class IdOf, class ParentOf>
+    void build(size_t n, IdOf&& id, ParentOf&& parent);
+
+    size_t size() const { return recordId.size(); }
+    size_t missingParents() const { return missing; }
+    // Records whose ID is id
+    RecordRange records(string_view id) const;
+    // Records listing the ID of record r as (one of) their Parent
+    RecordRange children(uint32_t r) const;
+    // Calls visit(record) for every record carrying one of r's Parent IDs
+    template <class Visitor>
+    void forEachParent(uint32_t r, Visitor&& visit) const;
+
+    // All records above / below r (subtree includes r itself), ascending
+    vector<uint32_t> ancestors(uint32_t r) const;
+    vector<uint32_t> subtree(uint32_t r) const;
+    // Top-level records (no resolvable Parent) above r, or r itself if it is one
+    vector<uint32_t> roots(uint32_t r) const;
+    // Whole models of a set of hits (e.g. a range query): every record of every tree a hit belongs to, ascending
+    vector<uint32_t> models(const vector<uint32_t>& hits) const;
+
+private:
+    RecordRange range(const vector<uint32_t>& a, const vector<uint32_t>& begin, uint32_t i) const
+    {
+        return RecordRange{a.data() + begin[i], a.data() + begin[i + 1]};
+    }
+    // Walks down from the records on the stack, adding every record reached for the first time to seen and out
+    void markDown(vector<uint32_t>& stack, unordered_set<uint32_t>& seen, vector<uint32_t>& out) const;
+
+    StringDict ids;
+    vector<uint32_t> recordId;		// ID code of each record, NONE if it has no ID
+    vector<uint32_t> idBegin, idRecords;
+    vector<uint32_t> childBegin, childRecords;
+    vector<uint32_t> parentBegin, parentIds;
+    size_t missing = 0;
+};
+
+inline void GFFHierarchy::build(const vector<GFFEntry>& entries)
+{
+    static const string empty;
+    auto get = [&entries](size_t r, const char* key) -> string_view
+    {
+        auto it = entries[r].tags.find(key);
+        return it == entries[r].tags.end() ? string_view(empty) : string_view(it->second);
+    };
+    build(entries.size(), [&](size_t r) { return get(r, "ID"); }, [&](size_t r) { return get(r, "Parent"); });
+}
+
+inline void GFFHierarchy::build(const GFFTable& table)
+{
+    build(table.size(), [&table](size_t r) { return table.attribute(r, "ID"); },
+          [&table](size_t r) { return table.attribute(r, "Parent"); });
+}
+
+template <class IdOf, class ParentOf>
+void GFFHierarchy::build(size_t n, IdOf&& id, ParentOf&& parent)
+{
+    // The single pass over the records: intern IDs and Parent items
+    ids = StringDict();
+    recordId.assign(n, NONE);
+    parentBegin.assign(1, 0);
+    parentIds.clear();
+    for (size_t r = 0; r < n; ++r)
+    {
+        string_view rid = id(r);
+        if (!rid.empty())
+            recordId[r] = ids.intern(rid);
+        string_view p = parent(r);
+        if (!p.empty())
+            forEachValueItem(p, [this](string_view item)
+            {
+                if (!item.empty())
+                    parentIds.push_back(ids.intern(item));
+            });
+        parentBegin.push_back(static_cast<uint32_t>(parentIds.size()));
+    }
+
+    // Counting sorts into CSR; records stay ascending within each run
+    auto csr = [this](vector<uint32_t>& begin, vector<uint32_t>& out, auto&& forEachPair)
+    {
+        begin.assign(ids.size() + 1, 0);
+        forEachPair([&begin](uint32_t code, uint32_t) { ++begin[code + 1]; });
+        for (size_t c = 1; c < begin.size(); ++c)
+            begin[c] += begin[c - 1];
+        out.resize(begin.back());
+        vector<uint32_t> fill(begin.begin(), begin.end() - 1);
+        forEachPair([&](uint32_t code, uint32_t r) { out[fill[code]++] = r; });
+    };
+    csr(idBegin, idRecords, [this](auto&& add)
+    {
+        for (uint32_t r = 0; r < recordId.size(); ++r)
+            if (recordId[r] != NONE)
+                add(recordId[r], r);
+    });
+    csr(childBegin, childRecords, [this](auto&& add)
+    {
+        for (uint32_t r = 0; r + 1 < parentBegin.size(); ++r)
+            for (uint32_t e = parentBegin[r]; e < parentBegin[r + 1]; ++e)
+                if (e == parentBegin[r] || find(&parentIds[parentBegin[r]], &parentIds[e], parentIds[e]) == &parentIds[e])
+                    add(parentIds[e], r);
+    });
+    missing = 0;
+    for (uint32_t code : parentIds)
+        if (idBegin[code] == idBegin[code + 1])
+            ++missing;
+}
+
+inline RecordRange GFFHierarchy::records(string_view id) const
+{
+    int64_t code = ids.find(id);
+    if (code < 0 || static_cast<size_t>(code) >= ids.size())
+        return RecordRange{nullptr, nullptr};
+    return range(idRecords, idBegin, static_cast<uint32_t>(code));
+}
+
+inline RecordRange GFFHierarchy::children(uint32_t r) const
+{
+    if (recordId[r] == NONE)
+        return RecordRange{nullptr, nullptr};
+    return range(childRecords, childBegin, recordId[r]);
+}
+
+template <class Visitor>
+void GFFHierarchy::forEachParent(uint32_t r, Visitor&& visit) const
+{
+    for (uint32_t e = parentBegin[r]; e < parentBegin[r + 1]; ++e)
+        for (uint32_t p : range(idRecords, idBegin, parentIds[e]))
+            visit(p);
+}
+
+inline vector<uint32_t> GFFHierarchy::ancestors(uint32_t r) const
+{
+    vector<uint32_t> out, stack{r};
+    unordered_set<uint32_t> seen{r};
+    while (!stack.empty())
+    {
+        uint32_t x = stack.back();
+        stack.pop_back();
+        forEachParent(x, [&](uint32_t p)
+        {
+            if (seen.insert(p).second)
+            {
+                out.push_back(p);
+                stack.push_back(p);
+            }
+        });
+    }
+    sort(out.begin(), out.end());
+    return out;
+}
+
+inline vector<uint32_t> GFFHierarchy::subtree(uint32_t r) const
+{
+    vector<uint32_t> out{r}, stack{r};
+    unordered_set<uint32_t> seen{r};
+    while (!stack.empty())
+    {
+        uint32_t x = stack.back();
+        stack.pop_back();
+        for (uint32_t c : children(x))
+            if (seen.insert(c).second)
+            {
+                out.push_back(c);
+                stack.push_back(c);
+            }
+    }
+    sort(out.begin(), out.end());
+    return out;
+}
+
+inline vector<uint32_t> GFFHierarchy::roots(uint32_t r) const
+{
+    vector<uint32_t> out;
+    vector<uint32_t> up = ancestors(r);
+    up.push_back(r);
+    for (uint32_t a : up)
+    {
+        bool top = true;
+        forEachParent(a, [&top](uint32_t) { top = false; });
+        if (top)
+            out.push_back(a);
+    }
+    sort(out.begin(), out.end());
+    return out;
+}
+
+inline void GFFHierarchy::markDown(vector<uint32_t>& stack, unordered_set<uint32_t>& seen, vector<uint32_t>& out) const
+{
+    while (!stack.empty())
+    {
+        uint32_t x = stack.back();
+        stack.pop_back();
+        for (uint32_t c : children(x))
+            if (seen.insert(c).second)
+            {
+                out.push_back(c);
+                stack.push_back(c);
+            }
+    }
+}
+
+inline vector<uint32_t> GFFHierarchy::models(const vector<uint32_t>& hits) const
+{
+    // Climbs to the top-level records of every hit, then collects their trees. The sets only hold
+    // the records reached, so a query costs the size of its models, not of the file.
+    unordered_set<uint32_t> up, seen;
+    vector<uint32_t> stack, top, out;
+    for (uint32_t h : hits)
+    {
+        if (!up.insert(h).second)
+            continue;
+        stack.push_back(h);
+        while (!stack.empty())
+        {
+            uint32_t x = stack.back();
+            stack.pop_back();
+            bool isTop = true;
+            forEachParent(x, [&](uint32_t p)
+            {
+                isTop = false;
+                if (up.insert(p).second)
+                    stack.push_back(p);
+            });
+            if (isTop)
+                top.push_back(x);
+        }
+    }
+    auto collect = [&](uint32_t r)
+    {
+        if (seen.insert(r).second)
+        {
+            out.push_back(r);
+            stack.push_back(r);
+            markDown(stack, seen, out);
+        }
+    };
+    for (uint32_t t : top)
+        collect(t);
+    // A hit inside a cycle has no top-level record: keep it and what hangs below it
+    for (uint32_t h : hits)
+        collect(h);
+    sort(out.begin(), out.end());
+    return out;
+}
+
+#endif // GFF_HIERARCHY_HPP
@@ -0,0 +1,265 @@
+#ifndef GFF_INDEX_HPP
+#define GFF_INDEX_HPP
+
+#include "gff_entry.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <string_view>
+#include <unordered_map>
+
+using namespace std;
+
+// IntervalNode: one feature in the interval index.
+// Nodes of a seqid are sorted by start and form an implicit binary tree over the array
+// (node i sits at level = number of trailing 1 bits of i); maxEnd is the largest end in its subtree.
+struct IntervalNode {
+    uint64_t start;
+    uint64_t end;
+    uint64_t maxEnd;
+    uint32_t record;	// position of the feature in the readGFF() vector
+    uint32_t pad;
+};
+
+// Sorts nodes by start and fills in maxEnd; returns the level of the root node
+inline int buildIntervalTree(IntervalNode* a, size_t n)
+{
+    if (n == 0)
+        return -1;
+    sort(a, a + n, [](const IntervalNode& x, const IntervalNode& y)
+    {
+        return x.start < y.start || (x.start == y.start && x.record < y.record);
+    });
+
+    // Leaves (even positions) only cover themselves
+    size_t lastI = 0;
+    uint64_t last = 0;
+    for (size_t i = 0; i < n; i += 2)
+    {
+        a[i].maxEnd = a[i].end;
+        lastI = i;
+        last = a[i].maxEnd;
+    }
+    for (size_t i = 1; i < n; i += 2)
+        a[i].maxEnd = a[i].end;
+
+    // Internal nodes, one level at a time; 'last' stands in for right children past the end of the array
+    int k = 1;
+    for (; (size_t(1) << k) <= n; ++k)
+    {
+        size_t x = size_t(1) << (k - 1), i0 = (x << 1) - 1, step = x << 2;
+        for (size_t i = i0; i < n; i += step)
+        {
+            uint64_t el = a[i - x].maxEnd;
+            uint64_t er = i + x < n ? a[i + x].maxEnd : last;
+            a[i].maxEnd = max(a[i].end, max(el, er));
+        }
+        lastI = (lastI >> k & 1) ? lastI - x : lastI + x;
+        if (lastI < n && a[lastI].maxEnd > last)
+            last = a[lastI].maxEnd;
+    }
+    return k - 1;
+}
+
+// Calls visit(record) for every node overlapping the closed interval [qs, qe]: O(log N + k)
+template <class Visitor>
+void overlapIntervalTree(const IntervalNode* a, size_t n, int maxLevel, uint64_t qs, uint64_t qe, Visitor&& visit)
+{
+    struct Frame { size_t x; int k; bool right; };
+    if (n == 0)
+        return;
+    Frame stack[64];
+    int top = 0;
+    stack[top++] = Frame{(size_t(1) << maxLevel) - 1, maxLevel, false};
+    while (top > 0)
+    {
+        Frame z = stack[--top];
+        if (z.k <= 3)
+        {
+            // Small subtree: a linear scan is cheaper than descending
+            size_t i0 = z.x >> z.k << z.k, i1 = min(n, i0 + (size_t(1) << (z.k + 1)) - 1);
+            for (size_t i = i0; i < i1 && a[i].start <= qe; ++i)
+                if (a[i].end >= qs)
+                    visit(a[i].record);
+        }
+        else if (!z.right)
+        {
+            // First visit: come back for this node and its right subtree after the left one
+            size_t y = z.x - (size_t(1) << (z.k - 1));
+            stack[top++] = Frame{z.x, z.k, true};
+            if (y >= n || a[y].maxEnd >= qs)
+                stack[top++] = Frame{y, z.k - 1, false};
+        }
+        else if (z.x < n && a[z.x].start <= qe)
+        {
+            if (a[z.x].end >= qs)
+                visit(a[z.x].record);
+            stack[top++] = Frame{z.x + (size_t(1) << (z.k - 1)), z.k - 1, false};
+        }
+    }
+}
+
+// Calls visit(record) for every node lying completely inside [qs, qe] (writeGFF() semantics).
+// Only nodes starting inside the interval are examined.
+template <class Visitor>
+void containedIntervalTree(const IntervalNode* a, size_t n, uint64_t qs, uint64_t qe, Visitor&& visit)
+{
+    const IntervalNode* i = lower_bound(a, a + n, qs, [](const IntervalNode& node, uint64_t s)
+    {
+        return node.start < s;
+    });
+    for (; i != a + n && i->start <= qe; ++i)
+        if (i->end <= qe)
+            visit(i->record);
+}
+
+// IntervalKey: the fields of a record the index is built from
+struct IntervalKey {
+    string_view seqid;
+    uint64_t start;
+    uint64_t end;
+};
+
+// GFFIndex: interval index over the output of readGFF(), built once and queried many times.
+// Seqids are interned to integer ids; each seqid owns a start-sorted slice of one node array.
+class GFFIndex
+{
+public:
+    GFFIndex() = default;
+    explicit GFFIndex(const vector<GFFEntry>& entries) { build(entries); }
+    // The id map holds views into 'names', so the index can be moved but not copied
+    GFFIndex(const GFFIndex&) = delete;
+    GFFIndex& operator=(const GFFIndex&) = delete;
+    GFFIndex(GFFIndex&&) = default;
+    GFFIndex& operator=(GFFIndex&&) = default;
+
+    void build(const vector<GFFEntry>& entries);
+    // Generic form: key(r) returns the IntervalKey of record r, for r in [0, n)
+    template <class KeyOf>
+    void build(size_t n, KeyOf&& key);
+    int seqidId(string_view seqid) const;
+    const string& seqidName(int id) const { return names[static_cast<size_t>(id)]; }
+    size_t seqidCount() const { return names.size(); }
+
+    // Record numbers (in file order) of features inside / overlapping [start, end] on seqid
+    vector<uint32_t> contained(string_view seqid, uint64_t start, uint64_t end) const;
+    vector<uint32_t> overlapping(string_view seqid, uint64_t start, uint64_t end) const;
+
+    const vector<IntervalNode>& nodes() const { return tree; }
+    const vector<size_t>& offsets() const { return seqOffset; }
+    const vector<int>& levels() const { return seqLevel; }
+
+private:
+    unordered_map<string_view, int> ids;	// seqid -> integer id (views into names)
+    deque<string> names;		// integer id -> seqid
+    vector<IntervalNode> tree;		// all nodes, grouped by seqid id
+    vector<size_t> seqOffset;		// nodes of seqid i are tree[seqOffset[i] .. seqOffset[i+1])
+    vector<int> seqLevel;		// root level of each seqid tree
+};
+
+inline void GFFIndex::build(const vector<GFFEntry>& entries)
+{
+    build(entries.size(), [&entries](size_t r)
+    {
+        return IntervalKey{entries[r].seqid, entries[r].start, entries[r].end};
+    });
+}
+
+// Interns seqids, groups features per seqid and builds one interval tree per group
+template <class KeyOf>
+void GFFIndex::build(size_t n, KeyOf&& key)
+{
+    ids.clear();
+    names.clear();
+    vector<int> seqOf(n);
+    vector<size_t> count;
+    for (size_t r = 0; r < n; ++r)
+    {
+        string_view seqid = key(r).seqid;
+        auto it = ids.find(seqid);
+        if (it == ids.end())
+        {
+            names.emplace_back(seqid);
+            it = ids.emplace(names.back(), static_cast<int>(names.size() - 1)).first;
+            count.push_back(0);
+        }
+        seqOf[r] = it->second;
+        ++count[static_cast<size_t>(it->second)];
+    }
+
+    // Counting sort by seqid id
+    seqOffset.assign(names.size() + 1, 0);
+    for (size_t s = 0; s < names.size(); ++s)
+        seqOffset[s + 1] = seqOffset[s] + count[s];
+    tree.resize(n);
+    vector<size_t> fill(seqOffset.begin(), seqOffset.end() - 1);
+    for (size_t r = 0; r < n; ++r)
+    {
+        IntervalKey k = key(r);
+        tree[fill[static_cast<size_t>(seqOf[r])]++] = IntervalNode{k.start, k.end, 0, static_cast<uint32_t>(r), 0};
+    }
+
+    seqLevel.resize(names.size());
+    for (size_t s = 0; s < names.size(); ++s)
+        seqLevel[s] = buildIntervalTree(tree.data() + seqOffset[s], seqOffset[s + 1] - seqOffset[s]);
+}
+
+// Returns the integer id of seqid, or -1 if it does not occur in the file
+inline int GFFIndex::seqidId(string_view seqid) const
+{
+    auto it = ids.find(seqid);
+    return it == ids.end() ? -1 : it->second;
+}
+
+inline vector<uint32_t> GFFIndex::contained(string_view seqid, uint64_t start, uint64_t end) const
+{
+    vector<uint32_t> out;
+    int id = seqidId(seqid);
+    if (id < 0)
+        return out;
+    size_t s = static_cast<size_t>(id);
+    containedIntervalTree(tree.data() + seqOffset[s], seqOffset[s + 1] - seqOffset[s], start, end,
+                          [&out](uint32_t r) { out.push_back(r); });
+    sort(out.begin(), out.end());
+    return out;
+}
+
+inline vector<uint32_t> GFFIndex::overlapping(string_view seqid, uint64_t start, uint64_t end) const
+{
+    vector<uint32_t> out;
+    int id = seqidId(seqid);
+    if (id < 0)
+        return out;
+    size_t s = static_cast<size_t>(id);
+    overlapIntervalTree(tree.data() + seqOffset[s], seqOffset[s + 1] - seqOffset[s], seqLevel[s], start, end,
+                        [&out](uint32_t r) { out.push_back(r); });
+    sort(out.begin(), out.end());
+    return out;
+}
+
+// GFFQuery: one "<seq_id> <start> <stop>" line of a batch query file
+struct GFFQuery {
+    string seqid;
+    uint64_t start;
+    uint64_t end;
+};
+
+// Reads batch queries, one "<seq_id> <start> <stop>" per line ('#' lines are skipped)
+inline vector<GFFQuery> readQueries(const string& filename)
+{
+    vector<GFFQuery> queries;
+    ifstream infile(filename);
+    string line;
+    while (getline(infile, line))
+    {
+        if (line.empty() || line[0] == '#')
+            continue;
+        istringstream row(line);
+        GFFQuery q;
+        if (row >> q.seqid >> q.start >> q.end)
+            queries.push_back(q);
+    }
+    return queries;
+}
+
+#endif // GFF_INDEX_HPP
@@ -0,0 +1,351 @@
+#ifndef GFF_JOIN_HPP
+#define GFF_JOIN_HPP
+
+#include "gff_entry.hpp"
+#include "gff_view.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <queue>
+#include <unistd.h>
+
+using namespace std;
+
+// Overlap join of two GFF3 files.
+// Both inputs are consumed as streams ordered by (seqid, start), seqids compared as strings; a
+// sweep line keeps the B features that can still overlap the current A feature in a heap ordered
+// by end, so the join costs O((N + M) log M) plus the size of the output instead of O(N * M).
+// Inputs that are not sorted are sorted in memory, or, when larger than the memory budget, with an
+// external merge sort through temporary files. Intervals are closed, as everywhere in GFF3.
+
+// JoinRecord: the sort key of a feature line and the line itself (without '\n')
+struct JoinRecord {
+    string_view seqid;
+    uint64_t start;
+    uint64_t end;
+    string_view line;
+};
+
+inline bool joinOrder(const JoinRecord& a, const JoinRecord& b)
+{
+    int c = a.seqid.compare(b.seqid);
+    return c < 0 || (c == 0 && a.start < b.start);
+}
+
+// Calls visit(JoinRecord) for every feature line of a buffer, in file order
+template <class Visitor>
+void forEachJoinRecord(string_view data, Visitor&& visit)
+{
+    GFFView v;
+    while (!data.empty())
+    {
+        size_t nl = data.find('\n');
+        string_view line = data.substr(0, nl);
+        data.remove_prefix(nl == string_view::npos ? data.size() : nl + 1);
+        if (parseGFFLine(line, v))
+        {
+            if (line.back() == '\r')
+                line.remove_suffix(1);
+            visit(JoinRecord{v.seqid, v.start, v.end, line});
+        }
+    }
+}
+
+// Temporary file that is deleted with the object
+class TempFile
+{
+public:
+    TempFile()
+    {
+        const char* dir = getenv("TMPDIR");
+        name = string(dir != nullptr && *dir != '\0' ? dir : "/tmp") + "/gff3join.XXXXXX";
+        int fd = mkstemp(&name[0]);
+        if (fd < 0)
+            name.clear();
+        else
+            ::close(fd);
+    }
+    TempFile(const TempFile&) = delete;
+    TempFile& operator=(const TempFile&) = delete;
+    ~TempFile()
+    {
+        if (!name.empty())
+            unlink(name.c_str());
+    }
+    bool ok() const { return !name.empty(); }
+    const string& path() const { return name; }
+
+private:
+    string name;
+};
+
+// SortedGFF: the feature lines of a GFF3 file in join order.
+// A sorted file is streamed straight from its mapping; an unsorted one is sorted in memory if its
+// size is within the budget, otherwise cut into sorted runs on disk that are merged into one file.
+class SortedGFF
+{
+public:
+    // Returns false if the file cannot be read or the temporary files cannot be written
+    bool open(const string& filename, size_t memoryBudget);
+    bool externallySorted() const { return merged != nullptr; }
+
+    // Next record in join order; false at the end
+    bool next(JoinRecord& r);
+
+private:
+    bool externalSort(size_t memoryBudget);
+
+    MappedFile file;
+    unique_ptr<TempFile> merged;	// output of the external sort
+    vector<JoinRecord> sorted;		// in-memory sort
+    bool inMemory = false;
+    size_t pos = 0;			// index into sorted, or byte offset into the mapping
+};
+
+inline bool SortedGFF::open(const string& filename, size_t memoryBudget)
+{
+    if (!file.open(filename))
+        return false;
+    // One pass to check the order
+    bool inOrder = true;
+    JoinRecord prev{string_view(), 0, 0, string_view()};
+    bool first = true;
+    forEachJoinRecord(file.view(), [&](const JoinRecord& r)
+    {
+        if (!first && joinOrder(r, prev))
+            inOrder = false;
+        prev = r;
+        first = false;
+    });
+    if (inOrder)
+        return true;
+    if (file.size() > memoryBudget)
+        return externalSort(memoryBudget);
+    forEachJoinRecord(file.view(), [this](const JoinRecord& r) { sorted.push_back(r); });
+    stable_sort(sorted.begin(), sorted.end(), joinOrder);
+    inMemory = true;
+    return true;
+}
+
+// Sorts budget-sized, line-aligned pieces into run files, then merges the runs with a heap
+inline bool SortedGFF::externalSort(size_t memoryBudget)
+{
+    vector<unique_ptr<TempFile>> runs;
+    string_view data = file.view();
+    vector<JoinRecord> piece;
+    size_t chunk = max(memoryBudget / 2, size_t(1) << 16);
+    for (size_t begin = 0; begin < data.size();)
+    {
+        size_t cut = min(data.size(), begin + chunk);
+        size_t nl = cut < data.size() ? data.find('\n', cut - 1) : string_view::npos;
+        cut = nl == string_view::npos ? data.size() : nl + 1;
+        piece.clear();
+        forEachJoinRecord(data.substr(begin, cut - begin), [&piece](const JoinRecord& r) { piece.push_back(r); });
+        begin = cut;
+        stable_sort(piece.begin(), piece.end(), joinOrder);
+        runs.emplace_back(new TempFile());
+        ofstream out(runs.back()->path(), ios::binary);
+        for (const auto& r : piece)
+            out << r.line << '\n';
+        if (!runs.back()->ok() || !out)
+            return false;
+    }
+    vector<JoinRecord>().swap(piece);
+
+    // k-way merge; equal keys come out in run order, which keeps the sort stable
+    struct Cursor {
+        MappedFile map;
+        string_view rest;
+        JoinRecord cur;
+    };
+    vector<Cursor> cursors(runs.size());
+    auto advance = [](Cursor& c)
+    {
+        bool got = false;
+        while (!got && !c.rest.empty())
+        {
+            size_t nl = c.rest.find('\n');
+            string_view line = c.rest.substr(0, nl);
+            c.rest.remove_prefix(nl == string_view::npos ? c.rest.size() : nl + 1);
+            forEachJoinRecord(line, [&](const JoinRecord& r) { c.cur = r; got = true; });
+        }
+        return got;
+    };
+    auto later = [&cursors](size_t a, size_t b)
+    {
+        return joinOrder(cursors[b].cur, cursors[a].cur) || (!joinOrder(cursors[a].cur, cursors[b].cur) && a > b);
+    };
+    priority_queue<size_t, vector<size_t>, decltype(later)> heap(later);
+    for (size_t i = 0; i < runs.size(); ++i)
+    {
+        if (!cursors[i].map.open(runs[i]->path()))
+            return false;
+        cursors[i].rest = cursors[i].map.view();
+        if (advance(cursors[i]))
+            heap.push(i);
+    }
+    merged.reset(new TempFile());
+    {
+        ofstream out(merged->path(), ios::binary);
+        while (!heap.empty())
+        {
+            size_t i = heap.top();
+            heap.pop();
+            out << cursors[i].cur.line << '\n';
+            if (advance(cursors[i]))
+                heap.push(i);
+        }
+        if (!merged->ok() || !out)
+            return false;
+    }
+    cursors.clear();
+    runs.clear();
+    return file.open(merged->path());
+}
+
+inline bool SortedGFF::next(JoinRecord& r)
+{
+    if (inMemory)
+    {
+        if (pos == sorted.size())
+            return false;
+        r = sorted[pos++];
+        return true;
+    }
+    string_view data = file.view();
+    bool got = false;
+    while (!got && pos < data.size())
+    {
+        size_t nl = data.find('\n', pos);
+        size_t end = nl == string_view::npos ? data.size() : nl;
+        forEachJoinRecord(data.substr(pos, end - pos), [&](const JoinRecord& x) { r = x; got = true; });
+        pos = nl == string_view::npos ? data.size() : nl + 1;
+    }
+    return got;
+}
+
+enum class JoinMode { Pairs, Nearest, Coverage };
+
+// Heap order of the sweep: smallest end on top
+struct JoinEndOrder {
+    bool operator()(const JoinRecord& x, const JoinRecord& y) const { return x.end > y.end; }
+};
+
+// Sweeps A and B in join order and writes, for every feature of A:
+//  Pairs:    "<A line>\t<B line>" for each overlapping B feature
+//  Nearest:  "<A line>\t<B line>\t<distance>" for the closest B feature(s) on the seqid, all
+//            overlapping ones at distance 0, otherwise the closest on either side; "\t.\t-1" if none
+//  Coverage: "<A line>\t<count>\t<bases covered>\t<length>\t<fraction>" of the B features overlapping it
+template <class Out>
+void joinGFF(SortedGFF& a, SortedGFF& b, JoinMode mode, Out&& out)
+{
+    vector<JoinRecord> active;	// B features that may overlap, a heap in JoinEndOrder
+    JoinRecord ra, rb, left{}, rightOf{};
+    bool haveB = b.next(rb), haveLeft = false;
+    string_view seqid;
+    vector<JoinRecord> hits;
+    vector<pair<uint64_t, uint64_t>> spans;
+    string line;
+
+    while (a.next(ra))
+    {
+        if (ra.seqid != seqid)
+        {
+            // New seqid: drop the old state and skip B features on seqids A does not have
+            seqid = ra.seqid;
+            active.clear();
+            haveLeft = false;
+            while (haveB && rb.seqid < seqid)
+                haveB = b.next(rb);
+        }
+        // Admits B features starting up to the end of this A feature
+        while (haveB && rb.seqid == seqid && rb.start <= ra.end)
+        {
+            active.push_back(rb);
+            push_heap(active.begin(), active.end(), JoinEndOrder());
+            haveB = b.next(rb);
+        }
+        // Retires those ending before it: A starts only grow, so they can never overlap again
+        while (!active.empty() && active.front().end < ra.start)
+        {
+            if (!haveLeft || active.front().end >= left.end)
+                left = active.front();
+            haveLeft = true;
+            pop_heap(active.begin(), active.end(), JoinEndOrder());
+            active.pop_back();
+        }
+
+        // Active features overlap ra unless an earlier, longer A feature admitted them: those start
+        // after ra ends and are right-hand neighbours instead. The heap is walked in place; of the
+        // neighbours with the smallest start the one ending first is taken, then the next B feature.
+        hits.clear();
+        const JoinRecord* right = nullptr;
+        for (const JoinRecord& h : active)
+        {
+            if (h.start <= ra.end)
+                hits.push_back(h);
+            else if (right == nullptr || h.start < right->start || (h.start == right->start && h.end < right->end)
+                     || (h.start == right->start && h.end == right->end && h.line.data() < right->line.data()))
+                right = &h;
+        }
+        if (right != nullptr)
+            rightOf = *right;
+        const JoinRecord* next = haveB && rb.seqid == seqid ? &rb : nullptr;
+        if (right != nullptr && (next == nullptr || rightOf.start < next->start))
+            next = &rightOf;
+        // Equal starts keep stream order: line pointers grow along the stream in every mode
+        sort(hits.begin(), hits.end(), [](const JoinRecord& x, const JoinRecord& y)
+        {
+            return x.start < y.start || (x.start == y.start && x.line.data() < y.line.data());
+        });
+
+        line.assign(ra.line);
+        if (mode == JoinMode::Pairs)
+            for (const auto& h : hits)
+                out(line + '\t' + string(h.line) + '\n');
+        else if (mode == JoinMode::Nearest)
+        {
+            if (!hits.empty())
+                for (const auto& h : hits)
+                    out(line + '\t' + string(h.line) + "\t0\n");
+            else if (!haveLeft && next == nullptr)
+                out(line + "\t.\t-1\n");
+            else
+            {
+                uint64_t dl = haveLeft ? ra.start - left.end : UINT64_MAX;
+                uint64_t dr = next != nullptr ? next->start - ra.end : UINT64_MAX;
+                if (dl <= dr)
+                    out(line + '\t' + string(left.line) + '\t' + to_string(dl) + '\n');
+                if (dr <= dl)
+                    out(line + '\t' + string(next->line) + '\t' + to_string(dr) + '\n');
+            }
+        }
+        else
+        {
+            // Union of the overlaps, clipped to ra
+            spans.clear();
+            for (const auto& h : hits)
+                spans.emplace_back(max(h.start, ra.start), min(h.end, ra.end));
+            sort(spans.begin(), spans.end());
+            uint64_t covered = 0, reach = 0;
+            bool open = false;
+            for (const auto& s : spans)
+            {
+                uint64_t from = open && s.first <= reach ? reach + 1 : s.first;
+                if (s.second >= from)
+                    covered += s.second - from + 1;
+                if (!open || s.second > reach)
+                    reach = s.second;
+                open = true;
+            }
+            uint64_t length = ra.end >= ra.start ? ra.end - ra.start + 1 : 0;
+            char fraction[32];
+            snprintf(fraction, sizeof(fraction), "%.7f", length > 0 ? static_cast<double>(covered) / static_cast<double>(length) : 0.0);
+            out(line + '\t' + to_string(hits.size()) + '\t' + to_string(covered) + '\t' + to_string(length) + '\t' + fraction + '\n');
+        }
+    }
+}
+
+#endif // GFF_JOIN_HPP
@@ -0,0 +1,105 @@
+#ifndef GFF_PARALLEL_HPP
+#define GFF_PARALLEL_HPP
+
+#include "gff_entry.hpp"
+#include "gff_view.hpp"
+
+#include <atomic>
+#include <thread>
+
+using namespace std;
+
+// Returns the thread count to use for a requested count (0 = one per hardware thread)
+inline unsigned threadCount(unsigned requested)
+{
+    if (requested > 0)
+        return requested;
+    unsigned hw = thread::hardware_concurrency();
+    return hw > 0 ? hw : 1;
+}
+
+// Runs task(i) for i in [0, tasks) on up to 'threads' worker threads.
+// Workers pull the next task index from a shared counter, so uneven tasks balance out.
+template <class Task>
+void runParallel(unsigned threads, size_t tasks, Task&& task)
+{
+    size_t workers = min<size_t>(threadCount(threads), tasks);
+    if (workers <= 1)
+    {
+        for (size_t i = 0; i < tasks; ++i)
+            task(i);
+        return;
+    }
+    atomic<size_t> next(0);
+    auto worker = [&]()
+    {
+        for (size_t i = next++; i < tasks; i = next++)
+            task(i);
+    };
+    vector<thread> pool;
+    for (size_t w = 1; w < workers; ++w)
+        pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool)
+        t.join();
+}
+
+// Splits a buffer into at most 'parts' pieces; every piece except the last ends with '\n'
+inline vector<string_view> splitLines(string_view data, size_t parts)
+{
+    vector<string_view> chunks;
+    size_t step = parts > 0 ? data.size() / parts + 1 : data.size();
+    size_t begin = 0;
+    while (begin < data.size())
+    {
+        size_t cut = begin + step;
+        if (cut >= data.size())
+            cut = data.size();
+        else
+        {
+            // Moves the cut past the end of the line it falls into
+            size_t nl = data.find('\n', cut - 1);
+            cut = nl == string_view::npos ? data.size() : nl + 1;
+        }
+        chunks.push_back(data.substr(begin, cut - begin));
+        begin = cut;
+    }
+    return chunks;
+}
+
+// Parses a buffer on 'threads' threads: newline-aligned chunks are parsed into per-chunk
+// vectors and then moved into one vector, preserving file order.
+inline vector<GFFEntry> parseGFFParallel(string_view data, unsigned threads)
+{
+    threads = threadCount(threads);
+    // A few chunks per thread keeps workers busy when chunks parse at different speeds
+    vector<string_view> chunks = splitLines(data, threads == 1 ? 1 : size_t(threads) * 4);
+    vector<vector<GFFEntry>> parts(chunks.size());
+    runParallel(threads, chunks.size(), [&](size_t c)
+    {
+        scanGFF(chunks[c], [&parts, c](const GFFView& v)
+        {
+            parts[c].push_back(toGFFEntry(v));
+        });
+    });
+
+    vector<size_t> offset(parts.size() + 1, 0);
+    for (size_t c = 0; c < parts.size(); ++c)
+        offset[c + 1] = offset[c] + parts[c].size();
+    vector<GFFEntry> entries(offset.back());
+    runParallel(threads, parts.size(), [&](size_t c)
+    {
+        move(parts[c].begin(), parts[c].end(), entries.begin() + static_cast<ptrdiff_t>(offset[c]));
+        vector<GFFEntry>().swap(parts[c]);
+    });
+    return entries;
+}
+
+// Multi-threaded counterpart of readGFF() (threads = 0 uses every hardware thread)
+inline vector<GFFEntry> readGFFParallel(const string& filename, unsigned threads)
+{
+    MappedFile file(filename);
+    return parseGFFParallel(file.view(), threads);
+}
+
+#endif // GFF_PARALLEL_HPP
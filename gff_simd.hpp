@@ -0,0 +1,172 @@
+#ifndef GFF_SIMD_HPP
+#define GFF_SIMD_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define GFF_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// Vectorized delimiter scanner for GFF3 text.
+// A block of bytes is scanned for '\t', ';', '=' and '\n' at once and the offsets of all
+// delimiters are written to an array; the line parser then walks that array instead of
+// searching the text byte by byte. The SSE4.2 and AVX2 kernels are compiled with target
+// attributes and picked at run time, so the binary still runs on CPUs without them.
+
+enum class SimdLevel { Scalar, SSE42, AVX2 };
+
+inline const char* simdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::AVX2:
+        return "avx2";
+    case SimdLevel::SSE42:
+        return "sse4.2";
+    default:
+        return "scalar";
+    }
+}
+
+// Best instruction set supported by the running CPU
+inline SimdLevel detectSimd()
+{
+#ifdef GFF_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse4.2"))
+        return SimdLevel::SSE42;
+#endif
+    return SimdLevel::Scalar;
+}
+
+// True for the four GFF3 delimiters
+inline bool isGFFDelim(char c)
+{
+    return c == '\t' || c == '\n' || c == ';' || c == '=';
+}
+
+// Appends the offsets of set bits in mask (relative to base) to out
+inline uint32_t* emitMask(uint64_t mask, uint32_t base, uint32_t* out)
+{
+    while (mask != 0)
+    {
+        *out++ = base + static_cast<uint32_t>(__builtin_ctzll(mask));
+        mask &= mask - 1;
+    }
+    return out;
+}
+
+// Scalar kernel: writes the offsets of all delimiters in p[0 .. n) to out, returns how many
+inline size_t scanDelimsScalar(const char* p, size_t n, uint32_t* out)
+{
+    uint32_t* o = out;
+    for (size_t i = 0; i < n; ++i)
+        if (isGFFDelim(p[i]))
+            *o++ = static_cast<uint32_t>(i);
+    return static_cast<size_t>(o - out);
+}
+
+#ifdef GFF_SIMD_X86
+// SSE4.2 kernel: PCMPESTRM matches 16 bytes against the delimiter set in one instruction
+__attribute__((target("sse4.2")))
+inline size_t scanDelimsSSE42(const char* p, size_t n, uint32_t* out)
+{
+    const __m128i set = _mm_setr_epi8('\t', '\n', ';', '=', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    uint32_t* o = out;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        __m128i m = _mm_cmpestrm(set, 4, chunk, 16, _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK);
+        o = emitMask(static_cast<uint64_t>(_mm_cvtsi128_si32(m)) & 0xFFFF, static_cast<uint32_t>(i), o);
+    }
+    // The scalar tail reports offsets relative to p + i
+    size_t tail = scanDelimsScalar(p + i, n - i, o);
+    for (size_t t = 0; t < tail; ++t)
+        o[t] += static_cast<uint32_t>(i);
+    return static_cast<size_t>(o + tail - out);
+}
+
+// Delimiter bit mask of 32 bytes: four byte compares OR-ed together
+__attribute__((target("avx2")))
+inline uint64_t delimMaskAVX2(const char* q)
+{
+    const __m256i tab = _mm256_set1_epi8('\t'), nl = _mm256_set1_epi8('\n');
+    const __m256i semi = _mm256_set1_epi8(';'), eq = _mm256_set1_epi8('=');
+    __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(q));
+    __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(c, tab), _mm256_cmpeq_epi8(c, nl)),
+                                _mm256_or_si256(_mm256_cmpeq_epi8(c, semi), _mm256_cmpeq_epi8(c, eq)));
+    return static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(m)));
+}
+
+// AVX2 kernel: two 32-byte masks are combined into one 64-bit mask per step
+__attribute__((target("avx2")))
+inline size_t scanDelimsAVX2(const char* p, size_t n, uint32_t* out)
+{
+    uint32_t* o = out;
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64)
+        o = emitMask(delimMaskAVX2(p + i) | (delimMaskAVX2(p + i + 32) << 32), static_cast<uint32_t>(i), o);
+    size_t tail = scanDelimsScalar(p + i, n - i, o);
+    for (size_t t = 0; t < tail; ++t)
+        o[t] += static_cast<uint32_t>(i);
+    return static_cast<size_t>(o + tail - out);
+}
+#endif
+
+typedef size_t (*DelimScanFn)(const char*, size_t, uint32_t*);
+
+// Kernel for an instruction set (falls back to scalar when it is not compiled in)
+inline DelimScanFn delimScanner(SimdLevel level)
+{
+#ifdef GFF_SIMD_X86
+    if (level == SimdLevel::AVX2)
+        return scanDelimsAVX2;
+    if (level == SimdLevel::SSE42)
+        return scanDelimsSSE42;
+#endif
+    (void)level;
+    return scanDelimsScalar;
+}
+
+// DelimCursor: yields the absolute offsets of delimiters in a buffer, one block at a time
+class DelimCursor
+{
+public:
+    static const size_t BLOCK = 1 << 16;
+
+    DelimCursor(const char* data, size_t size, SimdLevel level)
+        : base(data), n(size), scan(delimScanner(level)), pos(BLOCK) {}
+
+    // Offset of the next delimiter, or the buffer size when there are no more
+    size_t next()
+    {
+        while (idx == count)
+        {
+            if (scanned == n)
+                return n;
+            size_t len = n - scanned < BLOCK ? n - scanned : BLOCK;
+            count = scan(base + scanned, len, pos.data());
+            blockStart = scanned;
+            scanned += len;
+            idx = 0;
+        }
+        return blockStart + pos[idx++];
+    }
+
+private:
+    const char* base;
+    size_t n;
+    DelimScanFn scan;
+    vector<uint32_t> pos;	// delimiter offsets within the current block
+    size_t count = 0, idx = 0, blockStart = 0, scanned = 0;
+};
+
+#endif // GFF_SIMD_HPP
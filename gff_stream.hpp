@@ -0,0 +1,78 @@
+#ifndef GFF_STREAM_HPP
+#define GFF_STREAM_HPP
+
+#include "gff_view.hpp"
+
+#include <istream>
+
+using namespace std;
+
+// GFFRegion: a seqid and closed interval [start, end], matched the same way as writeGFF()
+// (a record matches when it lies completely inside the interval).
+struct GFFRegion {
+    string seqid;
+    uint64_t start;
+    uint64_t end;
+
+    bool contains(const GFFView& v) const { return v.seqid == seqid && v.start >= start && v.end <= end; }
+};
+
+// Calls visit(const GFFView&) for every record of a buffer that falls inside region.
+// The seqid is compared right after the first tab, so records on other sequences are
+// rejected without tokenizing the rest of their line.
+template <class Visitor>
+void scanGFFRegion(string_view data, const GFFRegion& region, Visitor&& visit)
+{
+    const string_view seqid(region.seqid);
+    GFFView e;
+    while (!data.empty())
+    {
+        size_t nl = data.find('\n');
+        string_view line = data.substr(0, nl);
+        data.remove_prefix(nl == string_view::npos ? data.size() : nl + 1);
+
+        // Predicate push-down: first column only
+        if (line.size() <= seqid.size() || line[seqid.size()] != '\t' || line.compare(0, seqid.size(), seqid) != 0)
+            continue;
+        if (parseGFFLine(line, e) && e.start >= region.start && e.end <= region.end)
+            visit(static_cast<const GFFView&>(e));
+    }
+}
+
+// Streams a GFF3 file through a fixed-size buffer and calls visit(const GFFView&) for records inside region.
+// Memory use is bounded by bufferSize (grown only for a single line longer than the buffer),
+// whatever the size of the file. Views are only valid during the callback.
+template <class Visitor>
+void streamGFF(istream& in, const GFFRegion& region, Visitor&& visit, size_t bufferSize = 1 << 20)
+{
+    vector<char> buf(bufferSize);
+    size_t have = 0;
+    bool eof = false;
+    while (!eof)
+    {
+        in.read(buf.data() + have, static_cast<streamsize>(buf.size() - have));
+        have += static_cast<size_t>(in.gcount());
+        eof = !in;
+
+        string_view chunk(buf.data(), have);
+        size_t lastNl = chunk.rfind('\n');
+        if (eof)
+        {
+            // The final line may not end with '\n'
+            scanGFFRegion(chunk, region, visit);
+            break;
+        }
+        if (lastNl == string_view::npos)
+        {
+            // A single line fills the buffer: make room for the rest of it
+            buf.resize(buf.size() * 2);
+            continue;
+        }
+        scanGFFRegion(chunk.substr(0, lastNl + 1), region, visit);
+        // Keeps the incomplete last line for the next read
+        have -= lastNl + 1;
+        memmove(buf.data(), buf.data() + lastNl + 1, have);
+    }
+}
+
+#endif // GFF_STREAM_HPP
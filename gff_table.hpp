@@ -0,0 +1,255 @@
+#ifndef GFF_TABLE_HPP
+#define GFF_TABLE_HPP
+
+#include "gff_entry.hpp"
+#include "gff_view.hpp"
+#include "gff_parallel.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <unordered_map>
+
+using namespace std;
+
+// StringDict: dictionary encoder, string -> dense code in order of first appearance.
+// Strings are stored back to back in 'chars'; code c spans chars[offsets[c] .. offsets[c+1]).
+// Lookups go through string_views into 'owned', so interning a known string does not allocate.
+struct StringDict {
+    StringDict() = default;
+    StringDict(const StringDict&) = delete;
+    StringDict& operator=(const StringDict&) = delete;
+    StringDict(StringDict&&) = default;
+    StringDict& operator=(StringDict&&) = default;
+
+    unordered_map<string_view, uint32_t> codes;
+    deque<string> owned;		// stable storage for the keys of 'codes'
+    vector<char> chars;
+    vector<uint64_t> offsets{0};
+
+    uint32_t intern(string_view s)
+    {
+        auto it = codes.find(s);
+        if (it != codes.end())
+            return it->second;
+        uint32_t code = static_cast<uint32_t>(owned.size());
+        owned.emplace_back(s);
+        codes.emplace(owned.back(), code);
+        chars.insert(chars.end(), s.begin(), s.end());
+        offsets.push_back(chars.size());
+        return code;
+    }
+    // Returns the code of s, or -1 if it was never interned
+    int64_t find(string_view s) const
+    {
+        auto it = codes.find(s);
+        return it == codes.end() ? -1 : static_cast<int64_t>(it->second);
+    }
+    string_view operator[](uint32_t code) const { return owned[code]; }
+    size_t size() const { return owned.size(); }
+};
+
+// GFFAttr: one key/value pair in the attribute arena of a GFFTable
+struct GFFAttr {
+    uint32_t key;	// code in GFFTable::keys
+    uint32_t length;	// value length
+    uint64_t offset;	// value position in GFFTable::values
+};
+
+// GFFTable: columnar (struct-of-arrays) feature store.
+// seqid/source/type are dictionary codes, numeric columns are contiguous arrays, and the
+// attributes of record r are attrs[attrBegin[r] .. attrBegin[r+1]), in file order with
+// duplicate keys resolved like GFFEntry::tags (the last one wins and keeps its place).
+class GFFTable
+{
+public:
+    void append(const GFFView& v);
+    void append(const GFFEntry& e);
+    void append(const GFFTable& other);
+
+    size_t size() const { return starts.size(); }
+    string_view seqid(size_t r) const { return seqids[seqidCol[r]]; }
+    string_view source(size_t r) const { return sources[sourceCol[r]]; }
+    string_view type(size_t r) const { return types[typeCol[r]]; }
+    uint64_t start(size_t r) const { return starts[r]; }
+    uint64_t end(size_t r) const { return ends[r]; }
+    float score(size_t r) const { return scores[r]; }
+    char strand(size_t r) const { return strands[r]; }
+    uint8_t phase(size_t r) const { return phases[r]; }
+    // Value of attribute key of record r ("" if the record has no such attribute)
+    string_view attribute(size_t r, string_view key) const;
+
+    GFFEntry entry(size_t r) const;
+    vector<uint32_t> contained(string_view seqid, uint64_t start, uint64_t end) const;
+
+    // Dictionaries and columns, for code that scans or serializes the table directly
+    StringDict seqids, sources, types, keys;
+    vector<uint32_t> seqidCol, sourceCol, typeCol;
+    vector<uint64_t> starts, ends;
+    vector<float> scores;
+    vector<char> strands;
+    vector<uint8_t> phases;
+    vector<uint64_t> attrBegin{0};
+    vector<GFFAttr> attrs;
+    vector<char> values;
+
+private:
+    void dropDuplicateAttributes(size_t first);
+};
+
+// Drops every attribute appended from position first whose key occurs again later in the record
+inline void GFFTable::dropDuplicateAttributes(size_t first)
+{
+    // Records have a handful of attributes: a quadratic scan beats any lookup structure
+    auto begin = attrs.begin() + static_cast<ptrdiff_t>(first);
+    auto out = begin;
+    for (auto it = begin; it != attrs.end(); ++it)
+    {
+        bool repeated = false;
+        for (auto later = it + 1; later != attrs.end() && !repeated; ++later)
+            repeated = later->key == it->key;
+        if (!repeated)
+            *out++ = *it;
+    }
+    attrs.erase(out, attrs.end());
+}
+
+inline void GFFTable::append(const GFFView& v)
+{
+    seqidCol.push_back(seqids.intern(v.seqid));
+    sourceCol.push_back(sources.intern(v.source));
+    typeCol.push_back(types.intern(v.type));
+    starts.push_back(v.start);
+    ends.push_back(v.end);
+    scores.push_back(v.score);
+    strands.push_back(v.strand);
+    phases.push_back(v.phase);
+    size_t first = attrs.size();
+    forEachAttribute(v.attributes, [this](string_view key, string_view val)
+    {
+        attrs.push_back(GFFAttr{keys.intern(key), static_cast<uint32_t>(val.size()), values.size()});
+        values.insert(values.end(), val.begin(), val.end());
+    });
+    dropDuplicateAttributes(first);
+    attrBegin.push_back(attrs.size());
+}
+
+inline void GFFTable::append(const GFFEntry& e)
+{
+    seqidCol.push_back(seqids.intern(e.seqid));
+    sourceCol.push_back(sources.intern(e.source));
+    typeCol.push_back(types.intern(e.type));
+    starts.push_back(e.start);
+    ends.push_back(e.end);
+    scores.push_back(e.score);
+    strands.push_back(e.strand);
+    phases.push_back(e.phase);
+    // Tags are unique already
+    forEachTag(e, [this](const string& key, const string& val)
+    {
+        attrs.push_back(GFFAttr{keys.intern(key), static_cast<uint32_t>(val.size()), values.size()});
+        values.insert(values.end(), val.begin(), val.end());
+    });
+    attrBegin.push_back(attrs.size());
+}
+
+// Appends all records of another table, translating its dictionary codes into this table's
+inline void GFFTable::append(const GFFTable& other)
+{
+    auto remap = [](StringDict& into, const StringDict& from)
+    {
+        vector<uint32_t> code(from.size());
+        for (uint32_t c = 0; c < from.size(); ++c)
+            code[c] = into.intern(from[c]);
+        return code;
+    };
+    vector<uint32_t> seqidMap = remap(seqids, other.seqids), sourceMap = remap(sources, other.sources);
+    vector<uint32_t> typeMap = remap(types, other.types), keyMap = remap(keys, other.keys);
+    for (uint32_t c : other.seqidCol)
+        seqidCol.push_back(seqidMap[c]);
+    for (uint32_t c : other.sourceCol)
+        sourceCol.push_back(sourceMap[c]);
+    for (uint32_t c : other.typeCol)
+        typeCol.push_back(typeMap[c]);
+    starts.insert(starts.end(), other.starts.begin(), other.starts.end());
+    ends.insert(ends.end(), other.ends.begin(), other.ends.end());
+    scores.insert(scores.end(), other.scores.begin(), other.scores.end());
+    strands.insert(strands.end(), other.strands.begin(), other.strands.end());
+    phases.insert(phases.end(), other.phases.begin(), other.phases.end());
+
+    // Each record keeps its attributes in file order; only their key codes are translated
+    uint64_t valueBase = values.size(), attrBase = attrs.size();
+    values.insert(values.end(), other.values.begin(), other.values.end());
+    for (const auto& t : other.attrs)
+        attrs.push_back(GFFAttr{keyMap[t.key], t.length, t.offset + valueBase});
+    for (size_t r = 1; r < other.attrBegin.size(); ++r)
+        attrBegin.push_back(other.attrBegin[r] + attrBase);
+}
+
+inline string_view GFFTable::attribute(size_t r, string_view key) const
+{
+    int64_t code = keys.find(key);
+    if (code < 0)
+        return string_view();
+    for (uint64_t a = attrBegin[r]; a < attrBegin[r + 1]; ++a)
+        if (attrs[a].key == code)
+            return string_view(values.data() + attrs[a].offset, attrs[a].length);
+    return string_view();
+}
+
+// Builds the equivalent GFFEntry of record r
+inline GFFEntry GFFTable::entry(size_t r) const
+{
+    GFFEntry each;
+    each.seqid = string(seqid(r));
+    each.source = string(source(r));
+    each.type = string(type(r));
+    each.start = starts[r];
+    each.end = ends[r];
+    each.score = scores[r];
+    each.strand = strands[r];
+    each.phase = phases[r];
+    for (uint64_t a = attrBegin[r]; a < attrBegin[r + 1]; ++a)
+        setTag(each, string(keys[attrs[a].key]), string(values.data() + attrs[a].offset, attrs[a].length));
+    return each;
+}
+
+// Records (in file order) on seqid lying completely inside [start, end]: a scan of three columns
+inline vector<uint32_t> GFFTable::contained(string_view seqid, uint64_t start, uint64_t end) const
+{
+    vector<uint32_t> out;
+    int64_t code = seqids.find(seqid);
+    if (code < 0)
+        return out;
+    for (size_t r = 0; r < size(); ++r)
+        if (seqidCol[r] == code && starts[r] >= start && ends[r] <= end)
+            out.push_back(static_cast<uint32_t>(r));
+    return out;
+}
+
+// Reads a GFF3 file straight into a GFFTable on 'threads' threads (0 = all hardware threads).
+// Each newline-aligned chunk fills its own table; the tables are then appended in file order.
+inline GFFTable readGFFTable(const string& filename, unsigned threads = 1)
+{
+    MappedFile file(filename);
+    threads = threadCount(threads);
+    vector<string_view> chunks = splitLines(file.view(), threads == 1 ? 1 : size_t(threads) * 4);
+    vector<GFFTable> parts(chunks.size());
+    runParallel(threads, chunks.size(), [&](size_t c)
+    {
+        scanGFF(chunks[c], [&parts, c](const GFFView& v)
+        {
+            parts[c].append(v);
+        });
+    });
+    if (parts.size() == 1)
+        return move(parts[0]);
+    GFFTable table;
+    for (auto& p : parts)
+    {
+        table.append(p);
+        p = GFFTable();
+    }
+    return table;
+}
+
+#endif // GFF_TABLE_HPP
@@ -0,0 +1,184 @@
+#ifndef GFF_VIEW_HPP
+#define GFF_VIEW_HPP
+
+#include "gff_entry.hpp"
+#include "gff_simd.hpp"
+#include "mapped_file.hpp"
+
+#include <charconv>
+#include <cstring>
+#include <string_view>
+#include <utility>
+
+using namespace std;
+
+// GFFView: one GFF3 record whose text columns point into the mapped file.
+// Only valid while the MappedFile (or buffer) it was scanned from is alive.
+struct GFFView {
+    string_view seqid;
+    string_view source;
+    string_view type;
+    uint64_t start;
+    uint64_t end;
+    float score;
+    char strand;
+    uint8_t phase;
+    string_view attributes;	// raw 9th column, e.g. "ID=gene1;Name=abc"
+};
+
+// string_view counterpart of checkDelim64()
+inline uint64_t parseField64(string_view d)
+{
+    if (d == ".")
+        return 0;
+    return parseDecimal(d.data(), d.data() + d.size());
+}
+
+// string_view counterpart of checkDelimf()
+inline float parseFieldf(string_view d)
+{
+    float v = 0;
+    if (d != ".")
+        from_chars(d.data(), d.data() + d.size(), v);
+    return v;
+}
+
+// string_view counterpart of checkDelim8()
+inline uint8_t parseField8(string_view d)
+{
+    if (d == ".")
+        return 0;
+    return static_cast<uint8_t>(parseDecimal(d.data(), d.data() + d.size()));
+}
+
+// Fills a view from the n columns of one line; false if there are fewer than 8 columns
+inline bool fillGFFView(const string_view* col, size_t n, GFFView& e)
+{
+    if (n < 8)
+        return false;
+    e.seqid = col[0];
+    e.source = col[1];
+    e.type = col[2];
+    e.start = parseField64(col[3]);
+    e.end = parseField64(col[4]);
+    e.score = parseFieldf(col[5]);
+    e.strand = col[6].empty() ? '.' : col[6][0];
+    e.phase = parseField8(col[7]);
+    e.attributes = n > 8 ? col[8] : string_view();
+    return true;
+}
+
+// Splits one line into its columns without copying.
+// Returns false for comments, blank lines and lines with fewer than 8 columns.
+inline bool parseGFFLine(string_view line, GFFView& e)
+{
+    if (line.empty() || line[0] == '#')
+        return false;
+    if (line.back() == '\r')
+        line.remove_suffix(1);
+
+    string_view col[9];
+    size_t n = 0;
+    const char* p = line.data();
+    const char* end = p + line.size();
+    // Hand-rolled tab scanner: the 9th column is whatever follows the 8th tab
+    while (n < 8)
+    {
+        const char* tab = static_cast<const char*>(memchr(p, '\t', static_cast<size_t>(end - p)));
+        if (tab == nullptr)
+            break;
+        col[n++] = string_view(p, static_cast<size_t>(tab - p));
+        p = tab + 1;
+    }
+    col[n++] = string_view(p, static_cast<size_t>(end - p));
+    return fillGFFView(col, n, e);
+}
+
+// Calls visit(key, value) for each "key=value" pair of a raw attribute column, in file order.
+// Pairs without '=' or with an empty value are skipped, the same as readGFF().
+template <class Visitor>
+void forEachAttribute(string_view attrs, Visitor&& visit)
+{
+    while (!attrs.empty())
+    {
+        size_t semi = attrs.find(';');
+        string_view pair = attrs.substr(0, semi);
+        attrs.remove_prefix(semi == string_view::npos ? attrs.size() : semi + 1);
+        size_t eq = pair.find('=');
+        if (eq == string_view::npos || eq + 1 == pair.size())
+            continue;
+        visit(pair.substr(0, eq), pair.substr(eq + 1));
+    }
+}
+
+// Builds an owning GFFEntry from a view (on demand, e.g. only for matching records)
+inline GFFEntry toGFFEntry(const GFFView& v)
+{
+    GFFEntry each;
+    each.seqid = string(v.seqid);
+    each.source = string(v.source);
+    each.type = string(v.type);
+    each.start = v.start;
+    each.end = v.end;
+    each.score = v.score;
+    each.strand = v.strand;
+    each.phase = v.phase;
+    forEachAttribute(v.attributes, [&each](string_view key, string_view val)
+    {
+        setTag(each, string(key), string(val));
+    });
+    return each;
+}
+
+// Instruction set used by scanGFF() unless told otherwise (detected once)
+inline SimdLevel defaultSimd()
+{
+    static const SimdLevel level = detectSimd();
+    return level;
+}
+
+// Calls visit(const GFFView&) for every feature line of an in-memory GFF3 buffer.
+// Column boundaries come from the vectorized delimiter scanner (see gff_simd.hpp).
+template <class Visitor>
+void scanGFF(string_view data, Visitor&& visit, SimdLevel level = defaultSimd())
+{
+    const char* p = data.data();
+    const size_t n = data.size();
+    DelimCursor delims(p, n, level);
+    GFFView e;
+    string_view col[9];
+    size_t lineStart = 0;
+    while (lineStart < n)
+    {
+        // Walks this line's delimiters: the first 8 tabs split the columns, the rest are skipped
+        size_t cols = 0, colStart = lineStart, d;
+        while ((d = delims.next()) < n && p[d] != '\n')
+            if (p[d] == '\t' && cols < 8)
+            {
+                col[cols++] = string_view(p + colStart, d - colStart);
+                colStart = d + 1;
+            }
+        size_t lineEnd = d;
+        if (lineEnd > lineStart && p[lineEnd - 1] == '\r')
+            --lineEnd;
+        col[cols++] = string_view(p + colStart, lineEnd >= colStart ? lineEnd - colStart : 0);
+
+        if (p[lineStart] != '#' && lineEnd > lineStart && fillGFFView(col, cols, e))
+            visit(static_cast<const GFFView&>(e));
+        lineStart = d + 1;
+    }
+}
+
+// Memory-mapped counterpart of readGFF(): same result, without the per-line stream copies
+inline vector<GFFEntry> readGFFMapped(const string& filename)
+{
+    vector<GFFEntry> data;
+    MappedFile file(filename);
+    scanGFF(file.view(), [&data](const GFFView& v)
+    {
+        data.push_back(toGFFEntry(v));
+    });
+    return data;
+}
+
+#endif // GFF_VIEW_HPP
@@ -0,0 +1,203 @@
+#ifndef GFF_WRITER_HPP
+#define GFF_WRITER_HPP
+
+#include "gff_entry.hpp"
+#include "gff_view.hpp"
+#include "gff_table.hpp"
+
+#include <cerrno>
+#include <charconv>
+#include <unistd.h>
+
+using namespace std;
+
+// GFFWriter: formats GFF3 lines straight into one reusable output buffer and hands it to the
+// file descriptor (or ostream) in large blocks. Numbers go through to_chars, so no temporary
+// strings are built, and records are written from const references without being copied.
+// Output is byte-for-byte what writeEntry() prints. On every path attributes come out in file
+// order, each key once at its last occurrence, so views, entries and tables of one input agree.
+class GFFWriter
+{
+public:
+    static const size_t DEFAULT_CAPACITY = 1 << 20;
+
+    // Writes to a file descriptor with write(2), e.g. STDOUT_FILENO
+    explicit GFFWriter(int descriptor, size_t capacity = DEFAULT_CAPACITY) : fd(descriptor), buf(capacity) {}
+    // Writes to a stream with ostream::write
+    explicit GFFWriter(ostream& stream, size_t capacity = DEFAULT_CAPACITY) : out(&stream), buf(capacity) {}
+    GFFWriter(const GFFWriter&) = delete;
+    GFFWriter& operator=(const GFFWriter&) = delete;
+    ~GFFWriter() { flush(); }
+
+    void write(const GFFView& v);
+    void write(const GFFEntry& e);
+    void write(const GFFTable& table, size_t r);
+    // Copies raw text (e.g. comment lines) into the output
+    void text(string_view s) { put(s); }
+    void flush();
+    bool good() const { return ok; }
+
+private:
+    // Returns room for n more bytes, flushing (or growing, for huge records) as needed
+    char* reserve(size_t n)
+    {
+        if (used + n > buf.size())
+        {
+            flush();
+            if (n > buf.size())
+                buf.resize(n);
+        }
+        return buf.data() + used;
+    }
+    void put(string_view s)
+    {
+        memcpy(reserve(s.size()), s.data(), s.size());
+        used += s.size();
+    }
+    void put(char c)
+    {
+        *reserve(1) = c;
+        ++used;
+    }
+    // writeCheck64() / writeCheck8(): 0 is written as '.'
+    void putNumber(uint64_t v)
+    {
+        if (v == 0)
+            return put('.');
+        char* p = reserve(20);
+        used = static_cast<size_t>(to_chars(p, p + 20, v).ptr - buf.data());
+    }
+    // writeCheckf(): 0 is written as '.', anything else as to_string() does ("%f")
+    void putScore(float v)
+    {
+        if (v == 0)
+            return put('.');
+        char* p = reserve(64);
+        auto res = to_chars(p, p + 64, v, chars_format::fixed, 6);
+        if (res.ec != errc())
+            return put(to_string(v));
+        used = static_cast<size_t>(res.ptr - buf.data());
+    }
+    void putColumns(string_view seqid, string_view source, string_view type, uint64_t start, uint64_t end,
+                    float score, char strand, uint8_t phase)
+    {
+        put(seqid);
+        put('\t');
+        put(source);
+        put('\t');
+        put(type);
+        put('\t');
+        putNumber(start);
+        put('\t');
+        putNumber(end);
+        put('\t');
+        putScore(score);
+        put('\t');
+        put(strand);
+        put('\t');
+        putNumber(phase);
+        put('\t');
+    }
+
+    int fd = -1;
+    ostream* out = nullptr;
+    vector<char> buf;
+    vector<pair<string_view, string_view>> pairs;	// attributes of the view being written
+    size_t used = 0;
+    bool ok = true;
+};
+
+// Writes a view; attributes keep the order they had in the file, a repeated key only its last pair
+inline void GFFWriter::write(const GFFView& v)
+{
+    putColumns(v.seqid, v.source, v.type, v.start, v.end, v.score, v.strand, v.phase);
+    pairs.clear();
+    forEachAttribute(v.attributes, [this](string_view key, string_view val) { pairs.emplace_back(key, val); });
+    bool first = true;
+    for (size_t i = 0; i < pairs.size(); ++i)
+    {
+        bool repeated = false;
+        for (size_t j = i + 1; j < pairs.size() && !repeated; ++j)
+            repeated = pairs[j].first == pairs[i].first;
+        if (repeated)
+            continue;
+        if (!first)
+            put(';');
+        first = false;
+        put(pairs[i].first);
+        put('=');
+        put(pairs[i].second);
+    }
+    put('\n');
+}
+
+// Writes an entry; tags in file order (see forEachTag)
+inline void GFFWriter::write(const GFFEntry& e)
+{
+    putColumns(e.seqid, e.source, e.type, e.start, e.end, e.score, e.strand, e.phase);
+    bool first = true;
+    forEachTag(e, [this, &first](const string& key, const string& val)
+    {
+        if (!first)
+            put(';');
+        first = false;
+        put(key);
+        put('=');
+        put(val);
+    });
+    put('\n');
+}
+
+// Writes record r of a columnar table (attributes in file order)
+inline void GFFWriter::write(const GFFTable& table, size_t r)
+{
+    putColumns(table.seqid(r), table.source(r), table.type(r), table.start(r), table.end(r),
+               table.score(r), table.strand(r), table.phase(r));
+    for (uint64_t a = table.attrBegin[r]; a < table.attrBegin[r + 1]; ++a)
+    {
+        if (a != table.attrBegin[r])
+            put(';');
+        put(table.keys[table.attrs[a].key]);
+        put('=');
+        put(string_view(table.values.data() + table.attrs[a].offset, table.attrs[a].length));
+    }
+    put('\n');
+}
+
+// Hands the buffered bytes to the descriptor or stream; a failed write stops further output
+inline void GFFWriter::flush()
+{
+    if (used == 0)
+        return;
+    if (ok && out != nullptr)
+        ok = static_cast<bool>(out->write(buf.data(), static_cast<streamsize>(used)));
+    else if (ok)
+    {
+        const char* p = buf.data();
+        size_t left = used;
+        while (left > 0)
+        {
+            ssize_t n = ::write(fd, p, left);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+            {
+                ok = false;
+                break;
+            }
+            p += n;
+            left -= static_cast<size_t>(n);
+        }
+    }
+    used = 0;
+}
+
+// writeGFF() through a GFFWriter: same filter, same output
+inline void writeGFF(const vector<GFFEntry>& entries, GFFWriter& out, const string& seqid, uint64_t start, uint64_t end)
+{
+    for (const auto& i : entries)
+        if (i.seqid == seqid && i.start >= start && i.end <= end)
+            out.write(i);
+}
+
+#endif // GFF_WRITER_HPP
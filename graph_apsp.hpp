@@ -0,0 +1,207 @@
+#ifndef GRAPH_APSP_HPP
+#define GRAPH_APSP_HPP
+
+#include "graph_csr.hpp"
+#include "graph_heap.hpp"
+#include "graph_parallel.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+// Multi-source and all-pairs shortest path distances.
+//   multiSourceDistances  one Dijkstra run per source, the sources spread over threads by work
+//                         stealing; each worker reuses its own heap across sources
+//   floydWarshall         blocked Floyd-Warshall on the whole V x V matrix, for dense graphs
+//                         where V^3 / blocks beats V Dijkstra runs of O(E log V)
+// Distances are int32_t; a distance that would reach DistanceMatrix::INF counts as unreachable.
+
+// DistanceMatrix: one row of V distances per source (and optionally V predecessors)
+class DistanceMatrix
+{
+public:
+    // INF + INF still fits in int32_t, so Floyd-Warshall can add two entries without a check
+    static constexpr int32_t INF = INT32_MAX / 2;
+
+    DistanceMatrix() = default;
+    DistanceMatrix(const vector<uint32_t>& sources, uint32_t numVertices, bool withPred = false)
+        : src(sources), n(numVertices), dist(sources.size() * size_t(numVertices), INF)
+    {
+        if (withPred)
+            pred.assign(dist.size(), -1);
+    }
+
+    size_t rows() const { return src.size(); }
+    uint32_t V() const { return n; }
+    uint32_t source(size_t r) const { return src[r]; }
+    bool hasPred() const { return !pred.empty(); }
+
+    int32_t* row(size_t r) { return dist.data() + r * n; }
+    const int32_t* row(size_t r) const { return dist.data() + r * n; }
+    int32_t* predRow(size_t r) { return hasPred() ? pred.data() + r * n : nullptr; }
+    // Distance from source(r) to v, INF if unreachable
+    int32_t at(size_t r, uint32_t v) const { return dist[r * n + v]; }
+    // Vertices on a shortest path from source(r) to v (needs predecessors; empty if unreachable)
+    vector<uint32_t> path(size_t r, uint32_t v) const;
+
+private:
+    vector<uint32_t> src;
+    uint32_t n = 0;
+    vector<int32_t> dist;
+    vector<int32_t> pred;	// -1 where not reached
+};
+
+inline vector<uint32_t> DistanceMatrix::path(size_t r, uint32_t v) const
+{
+    vector<uint32_t> out;
+    if (!hasPred() || pred[r * n + v] < 0)
+        return out;
+    for (uint32_t x = v; x != src[r]; x = static_cast<uint32_t>(pred[r * n + x]))
+        out.push_back(x);
+    out.push_back(src[r]);
+    reverse(out.begin(), out.end());
+    return out;
+}
+
+// SSSPScratch: per-worker state kept between sources. A complete run leaves the heap empty with
+// every position cleared, so it is only reset when the vertex count changes.
+struct SSSPScratch {
+    DaryHeap<4> heap;
+    uint32_t vertices = 0;
+};
+
+// Dijkstra from src writing V distances (and predecessors, if pred is not null) into the given rows
+inline void dijkstraRow(const CSRGraph& g, uint32_t src, SSSPScratch& s, int32_t* dist, int32_t* pred)
+{
+    uint32_t n = g.V();
+    if (s.vertices != n)
+    {
+        s.heap.reset(n);
+        s.vertices = n;
+    }
+    fill(dist, dist + n, DistanceMatrix::INF);
+    if (pred != nullptr)
+    {
+        fill(pred, pred + n, -1);
+        pred[src] = static_cast<int32_t>(src);
+    }
+    dist[src] = 0;
+    s.heap.push(src, 0);
+    while (!s.heap.empty())
+    {
+        uint32_t u = s.heap.top();
+        int64_t du = s.heap.topKey();
+        s.heap.pop();
+        EdgeRange adj = g.neighbors(u);
+        for (size_t e = 0; e < adj.size(); ++e)
+        {
+            // A settled vertex never improves (weights are non-negative), so no settled flags are needed
+            uint32_t v = adj.to[e];
+            int64_t dv = du + adj.weight[e];
+            if (dv >= dist[v])
+                continue;
+            dist[v] = static_cast<int32_t>(dv);
+            if (pred != nullptr)
+                pred[v] = static_cast<int32_t>(u);
+            if (s.heap.contains(v))
+                s.heap.decrease(v, dv);
+            else
+                s.heap.push(v, dv);
+        }
+    }
+}
+
+// Distances from each source to every vertex, on 'threads' threads (0 = one per hardware thread)
+inline DistanceMatrix multiSourceDistances(const CSRGraph& g, const vector<uint32_t>& sources, unsigned threads, bool withPred = false)
+{
+    DistanceMatrix m(sources, g.V(), withPred);
+    vector<SSSPScratch> scratch(min<size_t>(workerCount(threads), max<size_t>(sources.size(), 1)));
+    runStealing(threads, sources.size(), [&](size_t r, size_t worker)
+    {
+        dijkstraRow(g, sources[r], scratch[worker], m.row(r), m.predRow(r));
+    });
+    return m;
+}
+
+// All-pairs distances by one Dijkstra run per vertex
+inline DistanceMatrix allPairsDistances(const CSRGraph& g, unsigned threads, bool withPred = false)
+{
+    vector<uint32_t> sources(g.V());
+    for (uint32_t v = 0; v < g.V(); ++v)
+        sources[v] = v;
+    return multiSourceDistances(g, sources, threads, withPred);
+}
+
+// ri[j] = min(ri[j], dik + rk[j]) for j in [jb, jEnd); the rows never alias, so this vectorizes
+inline void floydWarshallRow(int32_t* __restrict ri, const int32_t* __restrict rk, int32_t dik, size_t jb, size_t jEnd)
+{
+    for (size_t j = jb; j < jEnd; ++j)
+        ri[j] = min(ri[j], dik + rk[j]);
+}
+
+// d[i][j] = min(d[i][j], d[i][k] + d[k][j]) over the rows, columns and pivots of three tiles.
+// The pivot loop is outermost, so a tile can be updated in place even when it is one of its inputs.
+// Row k is skipped for pivot k: with d[k][k] = 0 it cannot change.
+inline void floydWarshallTile(int32_t* d, size_t n, size_t ib, size_t jb, size_t kb, size_t tile)
+{
+    size_t iEnd = min(ib + tile, n), jEnd = min(jb + tile, n), kEnd = min(kb + tile, n);
+    for (size_t k = kb; k < kEnd; ++k)
+        for (size_t i = ib; i < iEnd; ++i)
+        {
+            int32_t dik = d[i * n + k];
+            if (i != k && dik < DistanceMatrix::INF)
+                floydWarshallRow(d + i * n, d + k * n, dik, jb, jEnd);
+        }
+}
+
+// All-pairs distances by blocked Floyd-Warshall with tile x tile blocks. For each pivot block:
+// the diagonal tile first, then the tiles in its block row and column, then all other tiles;
+// the tiles of the last two phases are independent and run in parallel.
+inline DistanceMatrix floydWarshall(const CSRGraph& g, unsigned threads, size_t tile = 64)
+{
+    uint32_t n = g.V();
+    vector<uint32_t> all(n);
+    for (uint32_t v = 0; v < n; ++v)
+        all[v] = v;
+    DistanceMatrix m(all, n);
+    int32_t* d = m.row(0);
+    for (uint32_t u = 0; u < n; ++u)
+    {
+        EdgeRange adj = g.neighbors(u);
+        for (size_t e = 0; e < adj.size(); ++e)
+            d[size_t(u) * n + adj.to[e]] = min(d[size_t(u) * n + adj.to[e]], min(adj.weight[e], DistanceMatrix::INF));
+        d[size_t(u) * n + u] = min(d[size_t(u) * n + u], 0);
+    }
+    if (n == 0)
+        return m;
+    size_t blocks = (n + tile - 1) / tile;
+    for (size_t kb = 0; kb < blocks; ++kb)
+    {
+        size_t k0 = kb * tile;
+        floydWarshallTile(d, n, k0, k0, k0, tile);
+        // Block row and block column of the pivot: 2 (blocks - 1) tiles
+        runStealing(threads, 2 * (blocks - 1), [&](size_t t, size_t)
+        {
+            size_t b = t / 2;
+            if (b >= kb)
+                ++b;
+            if (t % 2 == 0)
+                floydWarshallTile(d, n, k0, b * tile, k0, tile);
+            else
+                floydWarshallTile(d, n, b * tile, k0, k0, tile);
+        });
+        // Remaining tiles, one block row per task
+        runStealing(threads, blocks - 1, [&](size_t t, size_t)
+        {
+            size_t ib = t >= kb ? t + 1 : t;
+            for (size_t jb = 0; jb < blocks; ++jb)
+                if (jb != kb)
+                    floydWarshallTile(d, n, ib * tile, jb * tile, k0, tile);
+        });
+    }
+    return m;
+}
+
+#endif // GRAPH_APSP_HPP
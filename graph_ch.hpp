@@ -0,0 +1,575 @@
+#ifndef GRAPH_CH_HPP
+#define GRAPH_CH_HPP
+
+#include "graph_csr.hpp"
+#include "graph_heap.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Contraction hierarchy: preprocessing that makes repeated point-to-point queries on a static graph
+// explore a few hundred vertices instead of a large part of the graph.
+// Vertices are contracted one by one in order of importance (fewest added shortcuts first, priorities
+// re-evaluated lazily when a vertex reaches the top of the queue). Contracting v adds a shortcut
+// u -> w of weight w(u,v) + w(v,w) unless a bounded "witness" Dijkstra that avoids v finds a path
+// from u to w that is no longer. Every vertex keeps the arcs to vertices contracted after it (higher rank):
+//   up(v)    arcs v -> x with rank(x) > rank(v), searched forward from the source
+//   down(v)  arcs x -> v with rank(x) > rank(v), stored at v with x in 'to', searched backward from the target
+// A shortest path always climbs in rank and then descends, so a query is two upward searches that meet.
+// A shortcut remembers the vertex it bypasses ('via'), which unpacks it into the original arcs.
+
+// CHArc: arc of the hierarchy; via is the contracted vertex a shortcut bypasses (NONE for an original arc)
+struct CHArc {
+    uint32_t to;
+    int32_t weight;
+    uint32_t via;
+};
+
+struct CHRange {
+    const CHArc* first;
+    const CHArc* last;
+
+    const CHArc* begin() const { return first; }
+    const CHArc* end() const { return last; }
+    size_t size() const { return static_cast<size_t>(last - first); }
+};
+
+const char GRAPH_CH_MAGIC[8] = {'G', 'R', 'A', 'P', 'H', 'C', 'H', '\0'};
+const uint32_t GRAPH_CH_VERSION = 2;	// 2: fingerprint of the source graph
+
+// File header; rank, up offsets, up arcs, down offsets and down arcs follow in this order, native byte order
+struct CHFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t vertices;
+    uint64_t upArcs;
+    uint64_t downArcs;
+    uint64_t shortcuts;
+    uint64_t graphArcs;	// arcs of the graph the hierarchy was built from
+    uint64_t graphHash;	// graphHash() of that graph
+};
+
+// FNV-1a over the rows of a graph (targets and weights), to recognise the graph a hierarchy belongs to
+inline uint64_t graphHash(const CSRGraph& g)
+{
+    uint64_t h = 14695981039346656037ULL;
+    auto mix = [&h](uint64_t x)
+    {
+        for (int i = 0; i < 8; ++i, x >>= 8)
+            h = (h ^ (x & 0xFF)) * 1099511628211ULL;
+    };
+    mix(g.V());
+    for (uint32_t v = 0; v < g.V(); ++v)
+    {
+        EdgeRange adj = g.neighbors(v);
+        mix(adj.size());
+        for (size_t i = 0; i < adj.size(); ++i)
+            mix(uint64_t(adj.to[i]) << 32 | static_cast<uint32_t>(adj.weight[i]));
+    }
+    return h;
+}
+
+class ContractionHierarchy
+{
+public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    // Contracts every vertex of g; witnessLimit bounds the vertices settled by one witness search
+    // (a smaller limit preprocesses faster but may add unnecessary shortcuts)
+    void build(const CSRGraph& g, size_t witnessLimit = 1000);
+    // Writes / reads the hierarchy; false on I/O errors or a file that is not a hierarchy
+    bool save(const string& filename) const;
+    bool load(const string& filename);
+    // The hierarchy was built (or loaded from a file built) from a graph with the arcs and weights of g
+    bool builtFrom(const CSRGraph& g) const
+    {
+        return V() == g.V() && sourceArcs == g.arcs() && sourceHash == graphHash(g);
+    }
+
+    uint32_t V() const { return static_cast<uint32_t>(ranks.size()); }
+    size_t shortcuts() const { return numShortcuts; }
+    uint32_t rank(uint32_t v) const { return ranks[v]; }
+    CHRange up(uint32_t v) const { return CHRange{upArcs.data() + upBegin[v], upArcs.data() + upBegin[v + 1]}; }
+    CHRange down(uint32_t v) const { return CHRange{downArcs.data() + downBegin[v], downArcs.data() + downBegin[v + 1]}; }
+    // The arc a -> b of the hierarchy, nullptr if there is none
+    const CHArc* arc(uint32_t a, uint32_t b) const;
+    // Appends the original vertices of the arc a -> b after a (a itself is not appended)
+    void unpack(uint32_t a, uint32_t b, vector<uint32_t>& out) const;
+
+private:
+    vector<uint32_t> ranks;
+    vector<uint32_t> upBegin{0}, downBegin{0};
+    vector<CHArc> upArcs, downArcs;	// rows sorted by 'to'
+    size_t numShortcuts = 0;
+    uint64_t sourceArcs = 0, sourceHash = 0;	// fingerprint of the graph it was built from
+};
+
+// Contraction state used by ContractionHierarchy::build()
+class CHContractor
+{
+public:
+    CHContractor(const CSRGraph& g, size_t witnessLimit);
+    // Lower is contracted earlier: shortcuts needed minus arcs removed, plus contracted neighbours.
+    // The shortcuts are kept for contract(v) as long as the graph does not change in between.
+    int64_t priority(uint32_t v)
+    {
+        findShortcuts(v);
+        return 2 * static_cast<int64_t>(pending.size()) - static_cast<int64_t>(out[v].size() + in[v].size()) + deleted[v];
+    }
+    // Adds the shortcuts bypassing v, removes v from the graph and returns its remaining arcs (all to
+    // higher ranked vertices); returns the number of shortcuts
+    size_t contract(uint32_t v, vector<CHArc>& up, vector<CHArc>& down);
+
+private:
+    // Shortcut u -> to bypassing v
+    struct Shortcut {
+        uint32_t from;
+        CHArc arc;
+    };
+    // Fills pending with the shortcuts contracting v needs
+    void findShortcuts(uint32_t v);
+    // Bounded Dijkstra from u over uncontracted vertices other than skip; stops early once every
+    // vertex marked in 'target' is settled
+    void witness(uint32_t u, uint32_t skip, int64_t maxDist, size_t targets);
+    void addArc(uint32_t u, uint32_t x, int32_t weight, uint32_t via);
+
+    vector<vector<CHArc> > out, in;	// in[v] holds arcs u -> v as {u, weight, via}
+    vector<char> contracted;
+    vector<int> deleted;
+    size_t limit;
+    DaryHeap<4> heap;
+    vector<int64_t> dist;
+    vector<uint32_t> seen;		// dist[v] is valid where seen[v] == stamp
+    vector<uint32_t> target;		// witness targets are marked with the stamp
+    uint32_t stamp = 0;
+    vector<Shortcut> pending;
+    uint32_t pendingFor = ContractionHierarchy::NONE;
+};
+
+inline CHContractor::CHContractor(const CSRGraph& g, size_t witnessLimit)
+    : out(g.V()), in(g.V()), contracted(g.V(), 0), deleted(g.V(), 0), limit(witnessLimit),
+      heap(g.V()), dist(g.V(), 0), seen(g.V(), 0), target(g.V(), 0)
+{
+    for (uint32_t u = 0; u < g.V(); ++u)
+    {
+        EdgeRange adj = g.neighbors(u);
+        for (size_t e = 0; e < adj.size(); ++e)
+            if (adj.to[e] != u)
+            {
+                out[u].push_back(CHArc{adj.to[e], adj.weight[e], ContractionHierarchy::NONE});
+                in[adj.to[e]].push_back(CHArc{u, adj.weight[e], ContractionHierarchy::NONE});
+            }
+    }
+}
+
+inline void CHContractor::witness(uint32_t u, uint32_t skip, int64_t maxDist, size_t targets)
+{
+    heap.clear();
+    seen[u] = stamp;
+    dist[u] = 0;
+    heap.push(u, 0);
+    for (size_t settled = 0; !heap.empty() && settled < limit && targets > 0; ++settled)
+    {
+        uint32_t x = heap.top();
+        int64_t dx = heap.topKey();
+        heap.pop();
+        if (dx > maxDist)
+            break;
+        if (target[x] == stamp)
+            --targets;
+        for (const CHArc& a : out[x])
+        {
+            if (a.to == skip || contracted[a.to])
+                continue;
+            int64_t d = dx + a.weight;
+            if (seen[a.to] == stamp && d >= dist[a.to])
+                continue;
+            dist[a.to] = d;
+            if (seen[a.to] == stamp && heap.contains(a.to))
+                heap.decrease(a.to, d);
+            else if (seen[a.to] != stamp)
+                heap.push(a.to, d);
+            seen[a.to] = stamp;
+        }
+    }
+}
+
+inline void CHContractor::addArc(uint32_t u, uint32_t x, int32_t weight, uint32_t via)
+{
+    for (CHArc& a : out[u])
+        if (a.to == x)
+        {
+            if (weight < a.weight)
+            {
+                a.weight = weight;
+                a.via = via;
+                for (CHArc& b : in[x])
+                    if (b.to == u)
+                    {
+                        b.weight = weight;
+                        b.via = via;
+                    }
+            }
+            return;
+        }
+    out[u].push_back(CHArc{x, weight, via});
+    in[x].push_back(CHArc{u, weight, via});
+}
+
+inline void CHContractor::findShortcuts(uint32_t v)
+{
+    pending.clear();
+    pendingFor = v;
+    for (const CHArc& inArc : in[v])
+    {
+        if (++stamp == 0)
+        {
+            fill(seen.begin(), seen.end(), 0);
+            fill(target.begin(), target.end(), 0);
+            stamp = 1;
+        }
+        int64_t maxOut = -1;
+        size_t targets = 0;
+        for (const CHArc& o : out[v])
+            if (o.to != inArc.to)
+            {
+                maxOut = max<int64_t>(maxOut, o.weight);
+                target[o.to] = stamp;
+                ++targets;
+            }
+        if (targets == 0)
+            continue;
+        // A path found by the search (settled or not) is a real path, so it is a valid witness
+        witness(inArc.to, v, inArc.weight + maxOut, targets);
+        for (const CHArc& o : out[v])
+        {
+            if (o.to == inArc.to)
+                continue;
+            int64_t through = static_cast<int64_t>(inArc.weight) + o.weight;
+            if (seen[o.to] != stamp || dist[o.to] > through)
+                pending.push_back(Shortcut{inArc.to, CHArc{o.to, static_cast<int32_t>(through), v}});
+        }
+    }
+}
+
+inline size_t CHContractor::contract(uint32_t v, vector<CHArc>& up, vector<CHArc>& down)
+{
+    if (pendingFor != v)
+        findShortcuts(v);
+    size_t added = pending.size();
+    for (const Shortcut& s : pending)
+        addArc(s.from, s.arc.to, s.arc.weight, s.arc.via);
+    pending.clear();
+    pendingFor = ContractionHierarchy::NONE;
+
+    up = out[v];
+    down = in[v];
+    contracted[v] = 1;
+    auto drop = [v](vector<CHArc>& arcs)
+    {
+        arcs.erase(remove_if(arcs.begin(), arcs.end(), [v](const CHArc& a) { return a.to == v; }), arcs.end());
+    };
+    for (const CHArc& a : up)
+    {
+        drop(in[a.to]);
+        ++deleted[a.to];
+    }
+    for (const CHArc& a : down)
+    {
+        drop(out[a.to]);
+        ++deleted[a.to];
+    }
+    vector<CHArc>().swap(out[v]);
+    vector<CHArc>().swap(in[v]);
+    return added;
+}
+
+inline void ContractionHierarchy::build(const CSRGraph& g, size_t witnessLimit)
+{
+    uint32_t n = g.V();
+    CHContractor c(g, witnessLimit);
+    DaryHeap<4> order(n);
+    for (uint32_t v = 0; v < n; ++v)
+        order.push(v, c.priority(v));
+
+    vector<vector<CHArc> > up(n), down(n);
+    ranks.assign(n, 0);
+    numShortcuts = 0;
+    sourceArcs = g.arcs();
+    sourceHash = graphHash(g);
+    uint32_t next = 0;
+    while (!order.empty())
+    {
+        // Lazy update: a vertex whose priority went up since it was queued goes back in the queue
+        uint32_t v = order.top();
+        order.pop();
+        int64_t p = c.priority(v);
+        if (!order.empty() && p > order.topKey())
+        {
+            order.push(v, p);
+            continue;
+        }
+        numShortcuts += c.contract(v, up[v], down[v]);
+        ranks[v] = next++;
+    }
+
+    // Rows into CSR, sorted by 'to' for arc()
+    auto pack = [n](vector<vector<CHArc> >& rows, vector<uint32_t>& begin, vector<CHArc>& arcs)
+    {
+        begin.assign(size_t(n) + 1, 0);
+        arcs.clear();
+        for (uint32_t v = 0; v < n; ++v)
+        {
+            sort(rows[v].begin(), rows[v].end(), [](const CHArc& a, const CHArc& b) { return a.to < b.to; });
+            arcs.insert(arcs.end(), rows[v].begin(), rows[v].end());
+            begin[v + 1] = static_cast<uint32_t>(arcs.size());
+            vector<CHArc>().swap(rows[v]);
+        }
+    };
+    pack(up, upBegin, upArcs);
+    pack(down, downBegin, downArcs);
+}
+
+inline const CHArc* ContractionHierarchy::arc(uint32_t a, uint32_t b) const
+{
+    // Stored at the lower ranked end
+    CHRange row = ranks[a] < ranks[b] ? up(a) : down(b);
+    uint32_t key = ranks[a] < ranks[b] ? b : a;
+    const CHArc* it = lower_bound(row.first, row.last, key, [](const CHArc& x, uint32_t k) { return x.to < k; });
+    return it != row.last && it->to == key ? it : nullptr;
+}
+
+inline void ContractionHierarchy::unpack(uint32_t a, uint32_t b, vector<uint32_t>& out) const
+{
+    // Depth-first over the shortcut tree, left half first
+    vector<pair<uint32_t, uint32_t> > stack{make_pair(a, b)};
+    while (!stack.empty())
+    {
+        pair<uint32_t, uint32_t> ab = stack.back();
+        stack.pop_back();
+        const CHArc* x = arc(ab.first, ab.second);
+        if (x == nullptr || x->via == NONE)
+        {
+            out.push_back(ab.second);
+            continue;
+        }
+        stack.push_back(make_pair(x->via, ab.second));
+        stack.push_back(make_pair(ab.first, x->via));
+    }
+}
+
+inline bool ContractionHierarchy::save(const string& filename) const
+{
+    CHFileHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, GRAPH_CH_MAGIC, sizeof(hdr.magic));
+    hdr.version = GRAPH_CH_VERSION;
+    hdr.vertices = V();
+    hdr.upArcs = upArcs.size();
+    hdr.downArcs = downArcs.size();
+    hdr.shortcuts = numShortcuts;
+    hdr.graphArcs = sourceArcs;
+    hdr.graphHash = sourceHash;
+    // Written under a temporary name and renamed, so readers never see a partial file
+    string tmpName = filename + ".tmp";
+    {
+        ofstream out(tmpName, ios::binary | ios::trunc);
+        auto put = [&out](const void* data, size_t bytes) { out.write(static_cast<const char*>(data), static_cast<streamsize>(bytes)); };
+        put(&hdr, sizeof(hdr));
+        put(ranks.data(), ranks.size() * sizeof(uint32_t));
+        put(upBegin.data(), upBegin.size() * sizeof(uint32_t));
+        put(upArcs.data(), upArcs.size() * sizeof(CHArc));
+        put(downBegin.data(), downBegin.size() * sizeof(uint32_t));
+        put(downArcs.data(), downArcs.size() * sizeof(CHArc));
+        if (!out)
+        {
+            remove(tmpName.c_str());
+            return false;
+        }
+    }
+    return rename(tmpName.c_str(), filename.c_str()) == 0;
+}
+
+inline bool ContractionHierarchy::load(const string& filename)
+{
+    ifstream in(filename, ios::binary | ios::ate);
+    uint64_t fileSize = in ? static_cast<uint64_t>(in.tellg()) : 0;
+    in.seekg(0);
+    CHFileHeader hdr;
+    if (!in.read(reinterpret_cast<char*>(&hdr), sizeof(hdr)) || memcmp(hdr.magic, GRAPH_CH_MAGIC, sizeof(hdr.magic)) != 0
+        || hdr.version != GRAPH_CH_VERSION || hdr.vertices == UINT32_MAX || hdr.upArcs > UINT32_MAX || hdr.downArcs > UINT32_MAX)
+        return false;
+    // The sizes in the header must add up to the file size before anything is allocated for them
+    uint64_t n = hdr.vertices;
+    if (fileSize != sizeof(hdr) + (3 * n + 2) * sizeof(uint32_t) + (hdr.upArcs + hdr.downArcs) * sizeof(CHArc))
+        return false;
+    auto get = [&in](void* data, size_t bytes) { return static_cast<bool>(in.read(static_cast<char*>(data), static_cast<streamsize>(bytes))); };
+    ranks.resize(hdr.vertices);
+    upBegin.resize(size_t(hdr.vertices) + 1);
+    upArcs.resize(hdr.upArcs);
+    downBegin.resize(size_t(hdr.vertices) + 1);
+    downArcs.resize(hdr.downArcs);
+    numShortcuts = hdr.shortcuts;
+    sourceArcs = hdr.graphArcs;
+    sourceHash = hdr.graphHash;
+    bool ok = get(ranks.data(), ranks.size() * sizeof(uint32_t)) && get(upBegin.data(), upBegin.size() * sizeof(uint32_t))
+              && get(upArcs.data(), upArcs.size() * sizeof(CHArc)) && get(downBegin.data(), downBegin.size() * sizeof(uint32_t))
+              && get(downArcs.data(), downArcs.size() * sizeof(CHArc));
+    // Offsets must be monotone and end at the arc counts, or row access would run off the arrays
+    for (uint32_t v = 0; ok && v < hdr.vertices; ++v)
+        ok = upBegin[v] <= upBegin[v + 1] && downBegin[v] <= downBegin[v + 1];
+    ok = ok && upBegin[0] == 0 && downBegin[0] == 0 && upBegin.back() == upArcs.size() && downBegin.back() == downArcs.size();
+    // Arcs must stay inside the graph and ranks must number the vertices 0 .. V-1 once each
+    auto inside = [&hdr](const CHArc& a) { return a.to < hdr.vertices && (a.via == NONE || a.via < hdr.vertices); };
+    ok = ok && all_of(upArcs.begin(), upArcs.end(), inside) && all_of(downArcs.begin(), downArcs.end(), inside);
+    vector<char> ranked(ok ? hdr.vertices : 0, 0);
+    for (uint32_t v = 0; ok && v < hdr.vertices; ++v)
+    {
+        ok = ranks[v] < hdr.vertices && !ranked[ranks[v]];
+        if (ok)
+            ranked[ranks[v]] = 1;
+    }
+    if (!ok)
+        *this = ContractionHierarchy();
+    return ok;
+}
+
+// CHQuery: bidirectional upward search on a hierarchy. Each side stops once its queue minimum reaches
+// the best meeting distance. Scratch arrays are stamped per query like PointToPoint's.
+class CHQuery
+{
+public:
+    static constexpr int64_t UNREACHABLE = -1;
+
+    CHQuery() = default;
+    explicit CHQuery(const ContractionHierarchy& h) { bind(h); }
+    void bind(const ContractionHierarchy& h);
+
+    // Length of a shortest s-t path, UNREACHABLE if there is none
+    int64_t query(uint32_t s, uint32_t t);
+    int64_t length() const { return found; }
+    // Vertices of the path found by the last query in the original graph, s first (empty if unreachable)
+    vector<uint32_t> path() const;
+    size_t settled() const { return numSettled; }
+
+private:
+    struct Side {
+        vector<int64_t> dist;
+        vector<uint32_t> pred;
+        vector<uint32_t> reached;
+        DaryHeap<4> heap;
+    };
+
+    const ContractionHierarchy* ch = nullptr;
+    Side forward, backward;
+    uint32_t stamp = 0;
+    uint32_t source = 0, target = 0, meet = 0;
+    int64_t found = UNREACHABLE;
+    size_t numSettled = 0;
+};
+
+inline void CHQuery::bind(const ContractionHierarchy& h)
+{
+    ch = &h;
+    for (Side* side : {&forward, &backward})
+        if (side->reached.size() != h.V())
+        {
+            side->dist.assign(h.V(), 0);
+            side->pred.assign(h.V(), 0);
+            side->reached.assign(h.V(), 0);
+            side->heap.reset(h.V());
+        }
+}
+
+inline int64_t CHQuery::query(uint32_t s, uint32_t t)
+{
+    if (++stamp == 0)
+    {
+        fill(forward.reached.begin(), forward.reached.end(), 0);
+        fill(backward.reached.begin(), backward.reached.end(), 0);
+        stamp = 1;
+    }
+    source = s;
+    target = t;
+    numSettled = 0;
+    int64_t best = INT64_MAX;
+    for (Side* side : {&forward, &backward})
+    {
+        uint32_t from = side == &forward ? s : t;
+        side->heap.clear();
+        side->reached[from] = stamp;
+        side->dist[from] = 0;
+        side->pred[from] = from;
+        side->heap.push(from, 0);
+    }
+    auto step = [&](Side& side, const Side& other, bool up)
+    {
+        uint32_t u = side.heap.top();
+        int64_t du = side.heap.topKey();
+        side.heap.pop();
+        ++numSettled;
+        if (other.reached[u] == stamp && du + other.dist[u] < best)
+        {
+            best = du + other.dist[u];
+            meet = u;
+        }
+        for (const CHArc& a : up ? ch->up(u) : ch->down(u))
+        {
+            int64_t d = du + a.weight;
+            if (side.reached[a.to] == stamp && d >= side.dist[a.to])
+                continue;
+            bool queued = side.reached[a.to] == stamp && side.heap.contains(a.to);
+            side.reached[a.to] = stamp;
+            side.dist[a.to] = d;
+            side.pred[a.to] = u;
+            if (queued)
+                side.heap.decrease(a.to, d);
+            else
+                side.heap.push(a.to, d);
+        }
+    };
+    // Alternates between the sides; a side is done once its minimum cannot improve best
+    while (true)
+    {
+        bool f = !forward.heap.empty() && forward.heap.topKey() < best;
+        bool b = !backward.heap.empty() && backward.heap.topKey() < best;
+        if (!f && !b)
+            break;
+        if (f && (!b || forward.heap.topKey() <= backward.heap.topKey()))
+            step(forward, backward, true);
+        else
+            step(backward, forward, false);
+    }
+    found = best == INT64_MAX ? UNREACHABLE : best;
+    return found;
+}
+
+inline vector<uint32_t> CHQuery::path() const
+{
+    vector<uint32_t> hops, out;
+    if (found == UNREACHABLE)
+        return out;
+    // Hierarchy vertices: up from s to the meeting vertex, then down to t
+    for (uint32_t x = meet; x != source; x = forward.pred[x])
+        hops.push_back(x);
+    hops.push_back(source);
+    reverse(hops.begin(), hops.end());
+    for (uint32_t x = meet; x != target;)
+    {
+        x = backward.pred[x];
+        hops.push_back(x);
+    }
+    out.push_back(source);
+    for (size_t i = 1; i < hops.size(); ++i)
+        ch->unpack(hops[i - 1], hops[i], out);
+    return out;
+}
+
+#endif // GRAPH_CH_HPP
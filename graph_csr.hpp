@@ -0,0 +1,157 @@
+#ifndef GRAPH_CSR_HPP
+#define GRAPH_CSR_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+// WeightedEdge: one entry of an edge list, vertices numbered 0 .. V-1
+struct WeightedEdge {
+    uint32_t from;
+    uint32_t to;
+    int32_t weight;
+};
+
+// EdgeRange: neighbors of one vertex, two parallel runs of the CSR arrays
+struct EdgeRange {
+    const uint32_t* to;
+    const int32_t* weight;
+    size_t count;
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+};
+
+// CSRGraph: compressed sparse row graph.
+// The arcs leaving vertex v are targets[offsets[v] .. offsets[v+1]) with the matching weights; each
+// row is sorted by target, so iterating neighbors is a linear sweep over two arrays and an edge lookup
+// is a binary search, O(log deg). The structure is fixed once built; setWeight() changes the weight of
+// an existing edge in place and bumps version(), so code caching results can tell they are stale.
+class CSRGraph
+{
+public:
+    CSRGraph() : offset(1, 0) {}
+    // Builds from an edge list; an undirected graph stores every edge in both directions.
+    // A repeated edge keeps the weight of its last occurrence, like Graph::set_edge_value().
+    CSRGraph(uint32_t numVertices, const vector<WeightedEdge>& edges, bool isUndirected = true) { build(numVertices, edges, isUndirected); }
+
+    void build(uint32_t numVertices, const vector<WeightedEdge>& edges, bool isUndirected = true);
+
+    uint32_t V() const { return static_cast<uint32_t>(offset.size() - 1); }
+    // Number of edges (arcs for a directed graph)
+    size_t E() const { return numEdges; }
+    size_t arcs() const { return target.size(); }
+    bool isUndirected() const { return undirected; }
+    uint32_t degree(uint32_t v) const { return offset[v + 1] - offset[v]; }
+
+    EdgeRange neighbors(uint32_t v) const
+    {
+        return EdgeRange{target.data() + offset[v], weights.data() + offset[v], degree(v)};
+    }
+    // Weight of edge (u, v) in w; false if there is no such edge
+    bool edge(uint32_t u, uint32_t v, int32_t& w) const
+    {
+        size_t uv = arcIndex(u, v);
+        if (uv == NO_ARC)
+            return false;
+        w = weights[uv];
+        return true;
+    }
+    bool adjacent(uint32_t u, uint32_t v) const
+    {
+        int32_t w;
+        return edge(u, v, w);
+    }
+    // Sets the weight of edge (u, v) (both directions in an undirected graph); false if there is no such edge
+    bool setWeight(uint32_t u, uint32_t v, int32_t w)
+    {
+        size_t uv = arcIndex(u, v);
+        if (uv == NO_ARC)
+            return false;
+        weights[uv] = w;
+        if (undirected)
+            weights[arcIndex(v, u)] = w;
+        ++changes;
+        return true;
+    }
+    // Number of weight changes so far
+    uint64_t version() const { return changes; }
+
+    // Raw arrays, for code that sweeps the whole graph
+    const vector<uint32_t>& offsets() const { return offset; }
+    const vector<uint32_t>& targets() const { return target; }
+    const vector<int32_t>& weightsArray() const { return weights; }
+
+private:
+    static constexpr size_t NO_ARC = SIZE_MAX;
+    // Position of arc u -> v in the arrays, NO_ARC if there is none
+    size_t arcIndex(uint32_t u, uint32_t v) const
+    {
+        const uint32_t* first = target.data() + offset[u];
+        const uint32_t* last = target.data() + offset[u + 1];
+        const uint32_t* it = lower_bound(first, last, v);
+        return it == last || *it != v ? NO_ARC : static_cast<size_t>(it - target.data());
+    }
+
+    vector<uint32_t> offset;
+    vector<uint32_t> target;
+    vector<int32_t> weights;
+    size_t numEdges = 0;
+    bool undirected = true;
+    uint64_t changes = 0;
+};
+
+inline void CSRGraph::build(uint32_t numVertices, const vector<WeightedEdge>& edges, bool isUndirected)
+{
+    undirected = isUndirected;
+    // Counting sort of the arcs by source; arcs of a row stay in edge-list order
+    offset.assign(size_t(numVertices) + 1, 0);
+    for (const auto& e : edges)
+    {
+        ++offset[e.from + 1];
+        if (undirected && e.from != e.to)
+            ++offset[e.to + 1];
+    }
+    for (size_t v = 0; v < numVertices; ++v)
+        offset[v + 1] += offset[v];
+    vector<uint32_t> fill(offset.begin(), offset.end() - 1);
+    vector<pair<uint32_t, int32_t>> arc(offset.back());
+    for (const auto& e : edges)
+    {
+        arc[fill[e.from]++] = make_pair(e.to, e.weight);
+        if (undirected && e.from != e.to)
+            arc[fill[e.to]++] = make_pair(e.from, e.weight);
+    }
+
+    // Sorts each row by target and keeps the last of each run of equal targets
+    target.clear();
+    weights.clear();
+    numEdges = 0;
+    ++changes;
+    target.reserve(arc.size());
+    weights.reserve(arc.size());
+    uint32_t begin = 0;
+    for (size_t v = 0; v < numVertices; ++v)
+    {
+        auto first = arc.begin() + offset[v], last = arc.begin() + offset[v + 1];
+        stable_sort(first, last, [](const pair<uint32_t, int32_t>& a, const pair<uint32_t, int32_t>& b) { return a.first < b.first; });
+        for (auto it = first; it != last; ++it)
+        {
+            if (it + 1 != last && (it + 1)->first == it->first)
+                continue;
+            if (!undirected || it->first >= v)
+                ++numEdges;
+            target.push_back(it->first);
+            weights.push_back(it->second);
+        }
+        offset[v] = begin;
+        begin = static_cast<uint32_t>(target.size());
+    }
+    offset[numVertices] = begin;
+    target.shrink_to_fit();
+    weights.shrink_to_fit();
+}
+
+#endif // GRAPH_CSR_HPP
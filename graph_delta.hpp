@@ -0,0 +1,323 @@
+#ifndef GRAPH_DELTA_HPP
+#define GRAPH_DELTA_HPP
+
+#include "graph_apsp.hpp"
+#include "graph_csr.hpp"
+#include "graph_parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Parallel single-source shortest paths by delta-stepping (Meyer & Sanders).
+// Tentative distances are grouped into buckets of width delta: bucket i holds the vertices at distance
+// [i delta, (i+1) delta). The arcs are split once into light (weight <= delta) and heavy ones. Bucket i is
+// settled by relaxing the light arcs of its vertices until it stays empty (light arcs can refill it),
+// then the heavy arcs of every vertex taken from it, which only reach later buckets.
+// A small delta gets close to Dijkstra (little extra work, many small phases), a large one to
+// Bellman-Ford (few large phases, but vertices are relaxed more than once).
+// The vertices of a phase are shared out among the threads in chunks. Each vertex has one 64-bit label,
+// distance in the high half and predecessor in the low half, lowered with an atomic min, so a distance
+// and its predecessor always change together. The result does not depend on the number of threads:
+// pred[v] is the smallest u with dist[u] + w(u, v) = dist[v].
+// Threads live for the whole run and meet at a barrier between phases; phases too small to share
+// run on the calling thread alone.
+
+class DeltaStepping
+{
+public:
+    DeltaStepping() = default;
+    explicit DeltaStepping(const CSRGraph& g, int32_t delta = 0) { bind(g, delta); }
+    // Copies share nothing: the arcs are copied, the scratch space is allocated anew
+    DeltaStepping(const DeltaStepping& other) { *this = other; }
+    DeltaStepping& operator=(const DeltaStepping& other);
+    DeltaStepping(DeltaStepping&&) = default;
+    DeltaStepping& operator=(DeltaStepping&&) = default;
+    // Copies g with its arcs split at delta. delta = 0 picks the largest weight over the average degree;
+    // delta is raised if needed to keep the bucket ring (largest weight / delta) under a million buckets.
+    void bind(const CSRGraph& g, int32_t delta = 0);
+    uint32_t V() const { return n; }
+    int32_t delta() const { return width; }
+    // Every arc weight is positive, so run() gives a predecessor tree: with zero weights the smallest
+    // predecessor of two vertices at the same distance can be each other
+    bool positiveWeights() const { return positive; }
+
+    // Distances from src (DistanceMatrix::INF if unreachable) and predecessors (-1 if unreachable, pred
+    // may be null) into rows of V entries, on 'threads' threads (0 = one per hardware thread).
+    // Weights must be non-negative, and positive for the predecessors to form a tree.
+    void run(uint32_t src, unsigned threads, int32_t* dist, int32_t* pred);
+    // Phases (light or heavy relaxation rounds) of the last run
+    size_t phases() const { return numPhases; }
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+    static constexpr size_t CHUNK = 256;	// vertices taken by a thread at a time
+
+    static uint64_t pack(int64_t d, uint32_t p) { return (static_cast<uint64_t>(d) << 32) | p; }
+    int64_t distance(uint32_t v) const { return static_cast<int64_t>(label[v].load(memory_order_relaxed) >> 32); }
+    // Relaxes arcs [first, last) of u, appending each vertex whose distance dropped to 'lowered'
+    void relax(uint32_t u, uint32_t first, uint32_t last, vector<uint32_t>& lowered);
+    // Relaxes the frontier chunks not taken yet; 'next' is the first vertex of the next chunk
+    void relaxChunks(atomic<size_t>& next, vector<uint32_t>& lowered);
+    // Labels and buckets for the bound graph
+    void allocate(int32_t maxWeight);
+    // Files the lowered vertices into buckets and sets up the next phase; false once every bucket is empty
+    bool nextPhase();
+
+    uint32_t n = 0;
+    int32_t width = 1;
+    bool positive = true;
+    vector<uint32_t> begin;		// arcs of v: light in [begin[v], split[v]), heavy in [split[v], begin[v+1])
+    vector<uint32_t> split;
+    vector<uint32_t> to;
+    vector<int32_t> weight;
+
+    unique_ptr<atomic<uint64_t>[]> label;
+    vector<vector<uint32_t> > buckets;	// ring: bucket i is buckets[i % size]
+    size_t queued = 0;			// entries in the ring, stale ones included
+    uint64_t current = 0;		// bucket being settled
+    bool heavy = false;		// the running phase relaxes heavy arcs
+    vector<uint32_t> frontier;		// vertices of the running phase
+    vector<uint32_t> removed;		// vertices taken from the current bucket, for its heavy phase
+    vector<uint32_t> mark;		// mark[v] == stamp: v is in the frontier of the light phase
+    vector<char> taken;			// v is or was in 'removed'
+    uint32_t stamp = 0;
+    vector<vector<uint32_t> > lowered;	// per thread: vertices whose distance dropped in this phase
+    size_t numPhases = 0;
+};
+
+inline void DeltaStepping::bind(const CSRGraph& g, int32_t delta)
+{
+    n = g.V();
+    const vector<uint32_t>& offset = g.offsets();
+    const vector<uint32_t>& target = g.targets();
+    const vector<int32_t>& w = g.weightsArray();
+    int32_t maxWeight = 1;
+    positive = true;
+    for (int32_t x : w)
+    {
+        maxWeight = max(maxWeight, x);
+        positive = positive && x > 0;
+    }
+    if (delta <= 0)
+        delta = static_cast<int32_t>(max<int64_t>(1, static_cast<int64_t>(maxWeight) * max<uint32_t>(n, 1) / static_cast<int64_t>(max<size_t>(target.size(), 1))));
+    width = max(delta, maxWeight >> 20);
+    if (width < 1)
+        width = 1;
+
+    // Each row copied with its light arcs first
+    begin.assign(offset.begin(), offset.end());
+    split.assign(n, 0);
+    to.resize(target.size());
+    weight.resize(w.size());
+    for (uint32_t v = 0; v < n; ++v)
+    {
+        uint32_t lo = offset[v], hi = offset[v + 1];
+        for (uint32_t e = offset[v]; e < offset[v + 1]; ++e)
+        {
+            uint32_t slot = w[e] <= width ? lo++ : --hi;
+            to[slot] = target[e];
+            weight[slot] = w[e];
+        }
+        split[v] = lo;
+    }
+    allocate(maxWeight);
+}
+
+inline void DeltaStepping::allocate(int32_t maxWeight)
+{
+    label.reset(new atomic<uint64_t>[n]);
+    buckets.assign(static_cast<size_t>(maxWeight / width) + 2, vector<uint32_t>());
+    mark.assign(n, 0);
+    taken.assign(n, 0);
+}
+
+inline DeltaStepping& DeltaStepping::operator=(const DeltaStepping& other)
+{
+    if (this == &other)
+        return *this;
+    n = other.n;
+    width = other.width;
+    positive = other.positive;
+    begin = other.begin;
+    split = other.split;
+    to = other.to;
+    weight = other.weight;
+    int32_t maxWeight = 1;
+    for (int32_t x : weight)
+        maxWeight = max(maxWeight, x);
+    allocate(maxWeight);
+    return *this;
+}
+
+inline void DeltaStepping::relax(uint32_t u, uint32_t first, uint32_t last, vector<uint32_t>& out)
+{
+    int64_t du = distance(u);
+    for (uint32_t e = first; e < last; ++e)
+    {
+        int64_t d = du + weight[e];
+        if (d >= DistanceMatrix::INF)
+            continue;
+        uint64_t want = pack(d, u);
+        atomic<uint64_t>& slot = label[to[e]];
+        uint64_t old = slot.load(memory_order_relaxed);
+        while (want < old)
+        {
+            if (slot.compare_exchange_weak(old, want, memory_order_relaxed))
+            {
+                // Only a shorter distance needs another look; an equal one just took a smaller predecessor
+                if (static_cast<int64_t>(old >> 32) > d)
+                    out.push_back(to[e]);
+                break;
+            }
+        }
+    }
+}
+
+inline void DeltaStepping::relaxChunks(atomic<size_t>& next, vector<uint32_t>& out)
+{
+    while (true)
+    {
+        size_t first = next.fetch_add(CHUNK, memory_order_relaxed);
+        if (first >= frontier.size())
+            return;
+        size_t last = min(first + CHUNK, frontier.size());
+        for (size_t i = first; i < last; ++i)
+        {
+            uint32_t u = frontier[i];
+            if (heavy)
+                relax(u, split[u], begin[u + 1], out);
+            else
+                relax(u, begin[u], split[u], out);
+        }
+    }
+}
+
+inline bool DeltaStepping::nextPhase()
+{
+    for (auto& list : lowered)
+    {
+        for (uint32_t v : list)
+            buckets[static_cast<size_t>(distance(v) / width) % buckets.size()].push_back(v);
+        queued += list.size();
+        list.clear();
+    }
+    frontier.clear();
+    while (true)
+    {
+        if (!heavy)
+        {
+            // Light phase while the current bucket has entries; entries whose distance moved to an
+            // earlier bucket since they were filed are stale and dropped
+            vector<uint32_t>& bucket = buckets[current % buckets.size()];
+            if (!bucket.empty())
+            {
+                ++stamp;
+                for (uint32_t v : bucket)
+                    if (static_cast<uint64_t>(distance(v) / width) == current && mark[v] != stamp)
+                    {
+                        mark[v] = stamp;
+                        frontier.push_back(v);
+                        if (!taken[v])
+                        {
+                            taken[v] = 1;
+                            removed.push_back(v);
+                        }
+                    }
+                queued -= bucket.size();
+                bucket.clear();
+                if (!frontier.empty())
+                {
+                    ++numPhases;
+                    return true;
+                }
+                continue;
+            }
+            // The bucket stays empty: its distances are final, relax the heavy arcs
+            heavy = true;
+            if (!removed.empty())
+            {
+                frontier.swap(removed);
+                ++numPhases;
+                return true;
+            }
+        }
+        // Next non-empty bucket; the ring spans every distance still tentative, so it has one if any is left
+        heavy = false;
+        removed.clear();
+        if (queued == 0)
+            return false;
+        do
+            ++current;
+        while (buckets[current % buckets.size()].empty());
+    }
+}
+
+inline void DeltaStepping::run(uint32_t src, unsigned threads, int32_t* dist, int32_t* pred)
+{
+    for (uint32_t v = 0; v < n; ++v)
+        label[v].store(pack(DistanceMatrix::INF, NONE), memory_order_relaxed);
+    fill(mark.begin(), mark.end(), 0);
+    fill(taken.begin(), taken.end(), 0);
+    for (auto& bucket : buckets)
+        bucket.clear();
+    size_t workers = workerCount(threads);
+    lowered.assign(workers, vector<uint32_t>());
+    removed.clear();
+    stamp = 0;
+    queued = 0;
+    current = 0;
+    heavy = false;
+    numPhases = 0;
+
+    label[src].store(pack(0, src), memory_order_relaxed);
+    lowered[0].push_back(src);
+    // Phases with fewer vertices than this run on thread 0 without waking the others
+    size_t parallelFrom = workers > 1 ? 2 * CHUNK : SIZE_MAX;
+    bool finished = false;
+    atomic<size_t> next(0);
+    PhaseBarrier barrier(workers);
+    auto worker = [&](size_t w)
+    {
+        while (true)
+        {
+            if (w == 0)
+            {
+                bool more;
+                while ((more = nextPhase()) && frontier.size() < parallelFrom)
+                {
+                    next.store(0, memory_order_relaxed);
+                    relaxChunks(next, lowered[0]);
+                }
+                next.store(0, memory_order_relaxed);
+                finished = !more;
+            }
+            barrier.wait();
+            if (finished)
+                return;
+            relaxChunks(next, lowered[w]);
+            barrier.wait();
+        }
+    };
+    vector<thread> pool;
+    for (size_t w = 1; w < workers; ++w)
+        pool.emplace_back(worker, w);
+    worker(0);
+    for (auto& t : pool)
+        t.join();
+
+    for (uint32_t v = 0; v < n; ++v)
+    {
+        uint64_t x = label[v].load(memory_order_relaxed);
+        dist[v] = static_cast<int32_t>(x >> 32);
+        if (pred != nullptr)
+            pred[v] = static_cast<uint32_t>(x) == NONE ? -1 : static_cast<int32_t>(static_cast<uint32_t>(x));
+    }
+}
+
+#endif // GRAPH_DELTA_HPP
@@ -0,0 +1,154 @@
+#ifndef GRAPH_DSU_HPP
+#define GRAPH_DSU_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Disjoint-set union (union-find) over the elements 0 .. n-1, with 32-bit element numbers.
+//   DisjointSets            single thread: union by size and path halving, so a find costs
+//                           amortised O(alpha(n)) and the trees never get deep enough to matter;
+//                           find is a loop, not a recursion
+//   ConcurrentDisjointSets  lock-free, for uniting and querying from several threads at once:
+//                           parents are atomics, roots are linked with a compare-and-swap and finds
+//                           halve paths with compare-and-swaps that may fail harmlessly
+
+class DisjointSets
+{
+public:
+    DisjointSets() = default;
+    explicit DisjointSets(uint32_t n) { reset(n); }
+    // n singletons
+    void reset(uint32_t n)
+    {
+        parent.resize(n);
+        for (uint32_t x = 0; x < n; ++x)
+            parent[x] = x;
+        count.assign(n, 1);
+        numSets = n;
+    }
+    uint32_t size() const { return static_cast<uint32_t>(parent.size()); }
+    // Number of disjoint sets
+    uint32_t sets() const { return numSets; }
+
+    // Representative of the set of x; every other vertex on the way is pointed at its grandparent
+    uint32_t find(uint32_t x)
+    {
+        while (parent[x] != x)
+        {
+            parent[x] = parent[parent[x]];
+            x = parent[x];
+        }
+        return x;
+    }
+    // Merges the sets of x and y, the smaller under the larger; false if they were one set already
+    bool unite(uint32_t x, uint32_t y)
+    {
+        x = find(x);
+        y = find(y);
+        if (x == y)
+            return false;
+        if (count[x] < count[y])
+            swap(x, y);
+        parent[y] = x;
+        count[x] += count[y];
+        --numSets;
+        return true;
+    }
+    bool same(uint32_t x, uint32_t y) { return find(x) == find(y); }
+    // Number of elements in the set of x
+    uint32_t setSize(uint32_t x) { return count[find(x)]; }
+
+private:
+    vector<uint32_t> parent;
+    vector<uint32_t> count;	// set sizes, valid at the roots
+    uint32_t numSets = 0;
+};
+
+// Jayanti & Tarjan style concurrent union-find. Each element has one atomic parent word. A union
+// links the root with the lower priority under the other, which must still be a root: the CAS
+// from 'points to itself' fails if another thread linked it first, and the union starts over.
+// Priorities are a fixed random permutation of the elements (a hash of the number), which keeps the
+// trees shallow like linking by rank without a second word to update atomically with the parent.
+// Path halving writes are a CAS from the parent read before, so they only ever shorten a path.
+// Operations are linearizable; sets() is not kept, count roots once the threads are done.
+class ConcurrentDisjointSets
+{
+public:
+    ConcurrentDisjointSets() = default;
+    explicit ConcurrentDisjointSets(uint32_t n) { reset(n); }
+    // n singletons; not safe while other threads use the sets
+    void reset(uint32_t n)
+    {
+        parent.reset(new atomic<uint32_t>[n]);
+        for (uint32_t x = 0; x < n; ++x)
+            parent[x].store(x, memory_order_relaxed);
+        num = n;
+    }
+    uint32_t size() const { return num; }
+
+    uint32_t find(uint32_t x)
+    {
+        while (true)
+        {
+            uint32_t p = parent[x].load(memory_order_acquire);
+            if (p == x)
+                return x;
+            uint32_t g = parent[p].load(memory_order_acquire);
+            if (g != p)
+                parent[x].compare_exchange_weak(p, g, memory_order_release, memory_order_relaxed);
+            x = g;
+        }
+    }
+    bool unite(uint32_t x, uint32_t y)
+    {
+        while (true)
+        {
+            x = find(x);
+            y = find(y);
+            if (x == y)
+                return false;
+            if (priority(x) < priority(y))
+                swap(x, y);
+            uint32_t expected = y;
+            if (parent[y].compare_exchange_strong(expected, x, memory_order_acq_rel, memory_order_acquire))
+                return true;
+        }
+    }
+    // x and y in one set; a false answer holds at the moment x was last seen to be a root
+    bool same(uint32_t x, uint32_t y)
+    {
+        while (true)
+        {
+            x = find(x);
+            y = find(y);
+            if (x == y)
+                return true;
+            if (parent[x].load(memory_order_acquire) == x)
+                return false;
+        }
+    }
+    // x is the representative of its set (count these for the number of sets)
+    bool isRoot(uint32_t x) const { return parent[x].load(memory_order_acquire) == x; }
+
+private:
+    // Bijective 32-bit mix (MurmurHash3 finalizer), so no two elements share a priority
+    static uint32_t priority(uint32_t x)
+    {
+        x ^= x >> 16;
+        x *= 0x85EBCA6BU;
+        x ^= x >> 13;
+        x *= 0xC2B2AE35U;
+        x ^= x >> 16;
+        return x;
+    }
+
+    unique_ptr<atomic<uint32_t>[]> parent;
+    uint32_t num = 0;
+};
+
+#endif // GRAPH_DSU_HPP
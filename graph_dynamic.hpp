@@ -0,0 +1,307 @@
+#ifndef GRAPH_DYNAMIC_HPP
+#define GRAPH_DYNAMIC_HPP
+
+#include "graph_csr.hpp"
+#include "graph_heap.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+// Shortest-path trees kept up to date while edge weights change (after Ramalingam & Reps).
+// The trees of the registered sources are repaired instead of recomputed:
+//   weight drops    Dijkstra restarted from the head of the arc, reaching only the vertices that get closer
+//   weight rises    only if the arc is a tree arc: its subtree loses its distances, each subtree vertex takes
+//                   the best arc from outside the subtree, then Dijkstra runs inside the subtree
+// So the work is proportional to the vertices whose distance or predecessor changes (and their arcs).
+// The graph is shared, not copied: weights are read through the CSR arrays on every repair, and arcs
+// into a vertex are kept as positions in those arrays. Change a weight with CSRGraph::setWeight() and
+// then call weightChanged(); if the graph version moved by more than that one change, the trees are
+// recomputed instead (refresh() does the same before queries after changes nobody reported).
+
+class DynamicSSSP
+{
+public:
+    static constexpr int64_t UNREACHABLE = -1;
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    DynamicSSSP() = default;
+    explicit DynamicSSSP(const CSRGraph& graph) { bind(graph); }
+    // Works on g from now on (g must outlive this object); drops every source
+    void bind(const CSRGraph& g);
+
+    // Registers a source and computes its tree; does nothing if it is registered already
+    void addSource(uint32_t s);
+    void removeSource(uint32_t s);
+    bool hasSource(uint32_t s) const { return find(s) != nullptr; }
+
+    // Repairs the trees after the weight of edge (u, v) was changed from oldWeight to its current
+    // value (both arcs of an undirected edge)
+    void weightChanged(uint32_t u, uint32_t v, int32_t oldWeight);
+    // Recomputes every tree from scratch
+    void recompute();
+    // Recomputes the trees if the graph changed since they were last brought up to date
+    void refresh()
+    {
+        if (g != nullptr && version != g->version())
+            recompute();
+    }
+    size_t sources() const { return trees.size(); }
+
+    // Distance from registered source s to v, UNREACHABLE if there is none
+    int64_t distance(uint32_t s, uint32_t v) const;
+    // Predecessor of v on its shortest path from s (s for s itself, NONE if unreachable)
+    uint32_t predecessor(uint32_t s, uint32_t v) const;
+    // Vertices of a shortest s-v path, s first (empty if unreachable)
+    vector<uint32_t> path(uint32_t s, uint32_t v) const;
+    // Vertices whose label was recomputed by the last weightChanged(), over all trees
+    size_t touched() const { return numTouched; }
+
+private:
+    static constexpr int64_t INF = INT64_MAX;
+
+    struct Tree {
+        uint32_t source;
+        vector<int64_t> dist;	// INF where unreachable
+        vector<uint32_t> pred;	// NONE where unreachable
+    };
+
+    const Tree* find(uint32_t s) const;
+    void build(Tree& t);
+    // Arc u -> v became shorter / longer
+    void decreased(Tree& t, uint32_t u, uint32_t v, int32_t w);
+    void increased(Tree& t, uint32_t u, uint32_t v);
+    // Dijkstra from the vertices in 'heap'; only vertices with inside(x) are relaxed
+    template <class Inside>
+    void settle(Tree& t, Inside&& inside);
+
+    const CSRGraph* g = nullptr;
+    uint64_t version = 0;		// graph version the trees are valid for
+    vector<uint32_t> inBegin;		// arcs into v: inFrom / inArc [inBegin[v], inBegin[v+1])
+    vector<uint32_t> inFrom;
+    vector<uint32_t> inArc;		// position of the arc in the CSR arrays
+    vector<Tree> trees;
+    DaryHeap<4> heap;
+    vector<uint32_t> mark;		// mark[v] == stamp: v is in the subtree being repaired
+    uint32_t stamp = 0;
+    vector<uint32_t> subtree;
+    size_t numTouched = 0;
+};
+
+inline void DynamicSSSP::bind(const CSRGraph& graph)
+{
+    g = &graph;
+    version = graph.version();
+    uint32_t n = graph.V();
+    const vector<uint32_t>& offset = graph.offsets();
+    const vector<uint32_t>& target = graph.targets();
+    // Counting sort of the arcs by head
+    inBegin.assign(size_t(n) + 1, 0);
+    for (uint32_t x : target)
+        ++inBegin[x + 1];
+    for (uint32_t v = 0; v < n; ++v)
+        inBegin[v + 1] += inBegin[v];
+    vector<uint32_t> fill(inBegin.begin(), inBegin.end() - 1);
+    inFrom.resize(target.size());
+    inArc.resize(target.size());
+    for (uint32_t u = 0; u < n; ++u)
+        for (uint32_t e = offset[u]; e < offset[u + 1]; ++e)
+        {
+            uint32_t slot = fill[target[e]]++;
+            inFrom[slot] = u;
+            inArc[slot] = e;
+        }
+    trees.clear();
+    heap.reset(n);
+    mark.assign(n, 0);
+    stamp = 0;
+}
+
+inline const DynamicSSSP::Tree* DynamicSSSP::find(uint32_t s) const
+{
+    for (const Tree& t : trees)
+        if (t.source == s)
+            return &t;
+    return nullptr;
+}
+
+inline void DynamicSSSP::addSource(uint32_t s)
+{
+    refresh();
+    if (hasSource(s))
+        return;
+    trees.push_back(Tree{s, vector<int64_t>(), vector<uint32_t>()});
+    build(trees.back());
+}
+
+inline void DynamicSSSP::removeSource(uint32_t s)
+{
+    trees.erase(remove_if(trees.begin(), trees.end(), [s](const Tree& t) { return t.source == s; }), trees.end());
+}
+
+inline void DynamicSSSP::build(Tree& t)
+{
+    t.dist.assign(g->V(), INF);
+    t.pred.assign(g->V(), NONE);
+    t.dist[t.source] = 0;
+    t.pred[t.source] = t.source;
+    heap.push(t.source, 0);
+    settle(t, [](uint32_t) { return true; });
+}
+
+inline void DynamicSSSP::recompute()
+{
+    version = g->version();
+    for (Tree& t : trees)
+        build(t);
+}
+
+template <class Inside>
+void DynamicSSSP::settle(Tree& t, Inside&& inside)
+{
+    const vector<uint32_t>& offset = g->offsets();
+    const vector<uint32_t>& target = g->targets();
+    const vector<int32_t>& weight = g->weightsArray();
+    while (!heap.empty())
+    {
+        uint32_t x = heap.top();
+        int64_t dx = heap.topKey();
+        heap.pop();
+        ++numTouched;
+        for (uint32_t e = offset[x]; e < offset[x + 1]; ++e)
+        {
+            uint32_t y = target[e];
+            int64_t d = dx + weight[e];
+            if (d >= t.dist[y] || !inside(y))
+                continue;
+            t.dist[y] = d;
+            t.pred[y] = x;
+            if (heap.contains(y))
+                heap.decrease(y, d);
+            else
+                heap.push(y, d);
+        }
+    }
+}
+
+inline void DynamicSSSP::decreased(Tree& t, uint32_t u, uint32_t v, int32_t w)
+{
+    if (t.dist[u] == INF || t.dist[u] + w >= t.dist[v])
+        return;
+    t.dist[v] = t.dist[u] + w;
+    t.pred[v] = u;
+    heap.push(v, t.dist[v]);
+    settle(t, [](uint32_t) { return true; });
+}
+
+inline void DynamicSSSP::increased(Tree& t, uint32_t u, uint32_t v)
+{
+    if (t.pred[v] != u || v == t.source)
+        return;
+    // Subtree of v: the vertices whose shortest path used the arc
+    if (++stamp == 0)
+    {
+        fill(mark.begin(), mark.end(), 0);
+        stamp = 1;
+    }
+    const vector<uint32_t>& offset = g->offsets();
+    const vector<uint32_t>& target = g->targets();
+    const vector<int32_t>& weight = g->weightsArray();
+    subtree.assign(1, v);
+    mark[v] = stamp;
+    for (size_t i = 0; i < subtree.size(); ++i)
+    {
+        uint32_t x = subtree[i];
+        for (uint32_t e = offset[x]; e < offset[x + 1]; ++e)
+        {
+            uint32_t y = target[e];
+            if (t.pred[y] == x && mark[y] != stamp && y != t.source)
+            {
+                mark[y] = stamp;
+                subtree.push_back(y);
+            }
+        }
+    }
+    // Best way into each subtree vertex from outside, then shortest paths inside the subtree
+    for (uint32_t y : subtree)
+    {
+        t.dist[y] = INF;
+        t.pred[y] = NONE;
+        for (uint32_t a = inBegin[y]; a < inBegin[y + 1]; ++a)
+        {
+            uint32_t z = inFrom[a];
+            if (mark[z] == stamp || t.dist[z] == INF)
+                continue;
+            int64_t d = t.dist[z] + weight[inArc[a]];
+            if (d < t.dist[y])
+            {
+                t.dist[y] = d;
+                t.pred[y] = z;
+            }
+        }
+        if (t.dist[y] != INF)
+            heap.push(y, t.dist[y]);
+    }
+    settle(t, [this](uint32_t x) { return mark[x] == stamp; });
+}
+
+inline void DynamicSSSP::weightChanged(uint32_t u, uint32_t v, int32_t oldWeight)
+{
+    numTouched = 0;
+    int32_t w;
+    if (version == g->version())
+        return;		// recomputed since the change
+    if (version + 1 != g->version() || !g->edge(u, v, w))
+    {
+        // Missed other changes (or no such edge): repairs cannot be trusted
+        recompute();
+        return;
+    }
+    version = g->version();
+    if (w == oldWeight || u == v)
+        return;
+    for (Tree& t : trees)
+    {
+        if (w < oldWeight)
+        {
+            decreased(t, u, v, w);
+            if (g->isUndirected())
+                decreased(t, v, u, w);
+        }
+        else
+        {
+            increased(t, u, v);
+            if (g->isUndirected())
+                increased(t, v, u);
+        }
+    }
+}
+
+inline int64_t DynamicSSSP::distance(uint32_t s, uint32_t v) const
+{
+    const Tree* t = find(s);
+    return t == nullptr || t->dist[v] == INF ? UNREACHABLE : t->dist[v];
+}
+
+inline uint32_t DynamicSSSP::predecessor(uint32_t s, uint32_t v) const
+{
+    const Tree* t = find(s);
+    return t == nullptr ? NONE : t->pred[v];
+}
+
+inline vector<uint32_t> DynamicSSSP::path(uint32_t s, uint32_t v) const
+{
+    vector<uint32_t> out;
+    const Tree* t = find(s);
+    if (t == nullptr || t->pred[v] == NONE)
+        return out;
+    for (uint32_t x = v; x != s; x = t->pred[x])
+        out.push_back(x);
+    out.push_back(s);
+    reverse(out.begin(), out.end());
+    return out;
+}
+
+#endif // GRAPH_DYNAMIC_HPP
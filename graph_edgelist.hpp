@@ -0,0 +1,268 @@
+#ifndef GRAPH_EDGELIST_HPP
+#define GRAPH_EDGELIST_HPP
+
+#include "graph_parallel.hpp"
+#include "mapped_file.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Weighted edge lists read from files (the Kruskal input).
+//   text    the vertex count on the first line, then one "u v w" edge per line: unsigned integer
+//           vertices and a decimal weight, separated by spaces or tabs; blank lines are skipped
+//   binary  <input>.edgebin, written once from a parsed text file and read back by later runs without
+//           parsing; it records the size and mtime of the text file, so a changed input invalidates it
+// Text files are memory-mapped and parsed on several threads. The file is cut into line-aligned chunks,
+// the lines of every chunk are counted first so each chunk knows where its edges go, then the chunks
+// are parsed with from_chars straight into the columns.
+
+// Edges as three columns: edge i runs from[i] -- to[i] with weight[i]
+struct EdgeList {
+    uint32_t vertices = 0;	// as given in the file
+    vector<uint32_t> from;
+    vector<uint32_t> to;
+    vector<double> weight;
+
+    size_t size() const { return from.size(); }
+    void resize(size_t m)
+    {
+        from.resize(m);
+        to.resize(m);
+        weight.resize(m);
+    }
+};
+
+// Parses edge lines [first, last) of one chunk into the columns from slot 'out' on; returns the number
+// of edges parsed. On a malformed line stops and sets badLine to its number within the chunk (from 0).
+inline size_t parseEdgeLines(const char* first, const char* last, EdgeList& edges, size_t out, size_t& badLine)
+{
+    size_t start = out;
+    auto blank = [](char c) { return c == ' ' || c == '\t' || c == '\r'; };
+    for (size_t line = 0; first < last; ++line)
+    {
+        const char* end = static_cast<const char*>(memchr(first, '\n', static_cast<size_t>(last - first)));
+        if (end == nullptr)
+            end = last;
+        const char* p = first;
+        first = end + 1;
+        while (p < end && blank(*p))
+            ++p;
+        if (p == end)
+            continue;
+        uint32_t u = 0, v = 0;
+        double w = 0;
+        auto r = from_chars(p, end, u);
+        bool ok = r.ec == errc() && r.ptr < end && blank(*r.ptr);
+        for (p = r.ptr; ok && p < end && blank(*p); ++p)
+            ;
+        if (ok)
+        {
+            r = from_chars(p, end, v);
+            ok = r.ec == errc() && r.ptr < end && blank(*r.ptr);
+            for (p = r.ptr; ok && p < end && blank(*p); ++p)
+                ;
+        }
+        if (ok)
+        {
+            r = from_chars(p, end, w);
+            ok = r.ec == errc() && !std::isnan(w);
+            for (p = r.ptr; ok && p < end && blank(*p); ++p)
+                ;
+        }
+        if (!ok || p != end)
+        {
+            badLine = line;
+            break;
+        }
+        edges.from[out] = u;
+        edges.to[out] = v;
+        edges.weight[out] = w;
+        ++out;
+    }
+    return out - start;
+}
+
+// Parses a text edge list on 'threads' threads (0 = one per hardware thread); edges keep the file order.
+// Returns false with a message naming the line if the text is malformed.
+inline bool parseEdgeList(string_view text, unsigned threads, EdgeList& edges, string& error)
+{
+    edges = EdgeList();
+    // First line: the vertex count
+    size_t eol = text.find('\n');
+    string_view head = text.substr(0, eol);
+    while (!head.empty() && (head.back() == ' ' || head.back() == '\t' || head.back() == '\r'))
+        head.remove_suffix(1);
+    size_t skip = head.find_first_not_of(" \t");
+    auto r = from_chars(head.data() + min(skip, head.size()), head.data() + head.size(), edges.vertices);
+    if (skip == string_view::npos || r.ec != errc() || r.ptr != head.data() + head.size())
+    {
+        error = "line 1: expected the number of vertices";
+        return false;
+    }
+    string_view body = eol == string_view::npos ? string_view() : text.substr(eol + 1);
+
+    // Line-aligned chunks of at least 1 MB, a few per thread so uneven chunks balance out
+    size_t workers = workerCount(threads);
+    size_t parts = workers == 1 ? 1 : min(workers * 4, body.size() / (size_t(1) << 20) + 1);
+    vector<size_t> cut(1, 0);
+    for (size_t c = 1; c < parts; ++c)
+    {
+        size_t at = max(cut.back(), body.size() * c / parts);
+        size_t nl = at == 0 ? string_view::npos : body.find('\n', at - 1);
+        if (nl == string_view::npos)
+            break;
+        if (nl + 1 > cut.back())
+            cut.push_back(nl + 1);
+    }
+    if (cut.back() < body.size() || cut.size() == 1)
+        cut.push_back(body.size());
+    size_t chunks = cut.size() - 1;
+
+    // Lines per chunk (a last line without '\n' counts too) give every chunk its first slot
+    vector<size_t> lines(chunks + 1, 0);
+    runStealing(threads, chunks, [&](size_t c, size_t)
+    {
+        const char* first = body.data() + cut[c];
+        const char* last = body.data() + cut[c + 1];
+        size_t n = static_cast<size_t>(count(first, last, '\n'));
+        if (last > first && last[-1] != '\n')
+            ++n;
+        lines[c + 1] = n;
+    });
+    for (size_t c = 0; c < chunks; ++c)
+        lines[c + 1] += lines[c];
+    edges.resize(lines[chunks]);
+
+    vector<size_t> parsed(chunks, 0);
+    vector<size_t> badLine(chunks, SIZE_MAX);
+    runStealing(threads, chunks, [&](size_t c, size_t)
+    {
+        parsed[c] = parseEdgeLines(body.data() + cut[c], body.data() + cut[c + 1], edges, lines[c], badLine[c]);
+    });
+    for (size_t c = 0; c < chunks; ++c)
+        if (badLine[c] != SIZE_MAX)
+        {
+            error = "line " + to_string(lines[c] + badLine[c] + 2) + ": expected <vertex> <vertex> <weight>";
+            edges = EdgeList();
+            return false;
+        }
+
+    // Blank lines leave gaps at the chunk ends; close them
+    size_t m = 0;
+    for (size_t c = 0; c < chunks; ++c)
+    {
+        if (m != lines[c])
+            for (size_t i = 0; i < parsed[c]; ++i)
+            {
+                edges.from[m + i] = edges.from[lines[c] + i];
+                edges.to[m + i] = edges.to[lines[c] + i];
+                edges.weight[m + i] = edges.weight[lines[c] + i];
+            }
+        m += parsed[c];
+    }
+    edges.resize(m);
+    return true;
+}
+
+// Memory-maps and parses a text edge list (see parseEdgeList)
+inline bool readEdgeList(const string& filename, unsigned threads, EdgeList& edges, string& error)
+{
+    MappedFile file(filename);
+    if (!file.is_open())
+    {
+        error = "cannot open input file: " + filename;
+        return false;
+    }
+    return parseEdgeList(file.view(), threads, edges, error);
+}
+
+// Binary edge list: the header, then from, to and weight, each padded to 8 bytes, in native byte order
+const char EDGE_CACHE_MAGIC[8] = {'E', 'D', 'G', 'E', 'B', 'I', 'N', '\0'};
+const uint32_t EDGE_CACHE_VERSION = 1;
+
+struct EdgeCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t vertices;
+    uint64_t edges;
+    uint64_t sourceSize;
+    int64_t sourceMtime;	// nanoseconds since the epoch
+};
+
+// Cache file name used for an input file
+inline string edgeCacheFileName(const string& filename)
+{
+    return filename + ".edgebin";
+}
+
+// Writes the cache of the edges read from the text file filename.
+// The file is written under a temporary name and renamed, so readers never see a partial cache.
+inline bool writeEdgeCache(const string& filename, const EdgeList& edges)
+{
+    EdgeCacheHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, EDGE_CACHE_MAGIC, sizeof(hdr.magic));
+    hdr.version = EDGE_CACHE_VERSION;
+    hdr.vertices = edges.vertices;
+    hdr.edges = edges.size();
+    if (!fileStamp(filename, hdr.sourceSize, hdr.sourceMtime))
+        return false;
+
+    string tmpName = edgeCacheFileName(filename) + ".tmp";
+    {
+        ofstream out(tmpName, ios::binary | ios::trunc);
+        auto put = [&out](const void* data, size_t bytes)
+        {
+            static const char zeros[8] = {};
+            out.write(static_cast<const char*>(data), static_cast<streamsize>(bytes));
+            out.write(zeros, static_cast<streamsize>((8 - bytes % 8) % 8));
+        };
+        put(&hdr, sizeof(hdr));
+        put(edges.from.data(), edges.size() * sizeof(uint32_t));
+        put(edges.to.data(), edges.size() * sizeof(uint32_t));
+        put(edges.weight.data(), edges.size() * sizeof(double));
+        if (!out)
+        {
+            remove(tmpName.c_str());
+            return false;
+        }
+    }
+    return rename(tmpName.c_str(), edgeCacheFileName(filename).c_str()) == 0;
+}
+
+// Reads the cache of the text file filename; returns false if it is missing, corrupt or stale
+inline bool readEdgeCache(const string& filename, EdgeList& edges)
+{
+    uint64_t size;
+    int64_t mtime;
+    MappedFile file;
+    if (!fileStamp(filename, size, mtime) || !file.open(edgeCacheFileName(filename)) || file.size() < sizeof(EdgeCacheHeader))
+        return false;
+    EdgeCacheHeader hdr;
+    memcpy(&hdr, file.data(), sizeof(hdr));
+    auto padded = [](uint64_t bytes) { return (bytes + 7) / 8 * 8; };
+    if (memcmp(hdr.magic, EDGE_CACHE_MAGIC, sizeof(hdr.magic)) != 0 || hdr.version != EDGE_CACHE_VERSION
+        || hdr.sourceSize != size || hdr.sourceMtime != mtime || hdr.edges > file.size() / 16
+        || file.size() != padded(sizeof(hdr)) + 2 * padded(hdr.edges * sizeof(uint32_t)) + hdr.edges * sizeof(double))
+        return false;
+    size_t m = static_cast<size_t>(hdr.edges);
+    edges.vertices = hdr.vertices;
+    edges.resize(m);
+    const char* p = file.data() + padded(sizeof(hdr));
+    memcpy(edges.from.data(), p, m * sizeof(uint32_t));
+    p += padded(m * sizeof(uint32_t));
+    memcpy(edges.to.data(), p, m * sizeof(uint32_t));
+    p += padded(m * sizeof(uint32_t));
+    memcpy(edges.weight.data(), p, m * sizeof(double));
+    return true;
+}
+
+#endif // GRAPH_EDGELIST_HPP
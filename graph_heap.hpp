@@ -0,0 +1,243 @@
+#ifndef GRAPH_HEAP_HPP
+#define GRAPH_HEAP_HPP
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Indexed min-priority queues over items 0 .. n-1 with integer keys, for Dijkstra's algorithm.
+// Both keep a position map, so contains() and decrease-key are O(1) lookups instead of list scans:
+//   DaryHeap<D>  d-ary heap: push / decrease O(log_D n), pop O(D log_D n)
+//   RadixHeap    monotone radix heap (keys never drop below the last popped key, which holds for
+//                Dijkstra with non-negative weights): amortized O(log C) per item for keys up to C,
+//                with small integer weights (1 - 10 in MonteCarlo::randomGraph) nearly all work is O(1)
+// Common interface: reset(n), clear(), push(item, key), decrease(item, key), contains(item), key(item),
+// top(), topKey(), pop(), empty(), size().
+
+// d-ary heap with a position map (D = 2 is the binary heap)
+template <int D>
+class DaryHeap
+{
+public:
+    static constexpr uint32_t ABSENT = UINT32_MAX;
+
+    explicit DaryHeap(size_t n = 0) { reset(n); }
+
+    // Empties the heap and makes room for items 0 .. n-1
+    void reset(size_t n)
+    {
+        heap.clear();
+        pos.assign(n, ABSENT);
+        keys.resize(n);
+    }
+    // Empties the heap in O(size), keeping room for the same items
+    void clear()
+    {
+        for (uint32_t item : heap)
+            pos[item] = ABSENT;
+        heap.clear();
+    }
+    bool empty() const { return heap.empty(); }
+    size_t size() const { return heap.size(); }
+    bool contains(uint32_t item) const { return pos[item] != ABSENT; }
+    int64_t key(uint32_t item) const { return keys[item]; }
+    uint32_t top() const { return heap[0]; }
+    int64_t topKey() const { return keys[heap[0]]; }
+
+    void push(uint32_t item, int64_t k)
+    {
+        keys[item] = k;
+        pos[item] = static_cast<uint32_t>(heap.size());
+        heap.push_back(item);
+        siftUp(pos[item]);
+    }
+    // Lowers the key of an item already in the heap
+    void decrease(uint32_t item, int64_t k)
+    {
+        keys[item] = k;
+        siftUp(pos[item]);
+    }
+    void pop()
+    {
+        pos[heap[0]] = ABSENT;
+        uint32_t last = heap.back();
+        heap.pop_back();
+        if (!heap.empty())
+        {
+            heap[0] = last;
+            pos[last] = 0;
+            siftDown(0);
+        }
+    }
+
+private:
+    void siftUp(uint32_t i)
+    {
+        uint32_t item = heap[i];
+        int64_t k = keys[item];
+        while (i > 0)
+        {
+            uint32_t parent = (i - 1) / D;
+            if (keys[heap[parent]] <= k)
+                break;
+            heap[i] = heap[parent];
+            pos[heap[i]] = i;
+            i = parent;
+        }
+        heap[i] = item;
+        pos[item] = i;
+    }
+    void siftDown(uint32_t i)
+    {
+        uint32_t item = heap[i], n = static_cast<uint32_t>(heap.size());
+        int64_t k = keys[item];
+        while (true)
+        {
+            uint32_t first = i * D + 1;
+            if (first >= n)
+                break;
+            // Smallest of up to D children
+            uint32_t best = first;
+            for (uint32_t c = first + 1; c < first + D && c < n; ++c)
+                if (keys[heap[c]] < keys[heap[best]])
+                    best = c;
+            if (keys[heap[best]] >= k)
+                break;
+            heap[i] = heap[best];
+            pos[heap[i]] = i;
+            i = best;
+        }
+        heap[i] = item;
+        pos[item] = i;
+    }
+
+    vector<uint32_t> heap;	// items in heap order
+    vector<uint32_t> pos;	// item -> index in heap, ABSENT if not queued
+    vector<int64_t> keys;	// item -> current key
+};
+
+// Monotone radix heap with a position map.
+// Bucket b > 0 holds keys whose highest bit differing from the last popped key is bit b-1, bucket 0
+// holds keys equal to it. Popping empties the lowest non-empty bucket into lower ones, and each key
+// can only move down, which bounds the work per item by the number of buckets.
+class RadixHeap
+{
+public:
+    static constexpr uint32_t ABSENT = UINT32_MAX;
+    static constexpr int BUCKETS = 65;
+
+    explicit RadixHeap(size_t n = 0) { reset(n); }
+
+    void reset(size_t n)
+    {
+        for (auto& b : buckets)
+            b.clear();
+        bucketOf.assign(n, ABSENT);
+        slot.resize(n);
+        keys.resize(n);
+        last = 0;
+        count = 0;
+    }
+    void clear()
+    {
+        for (auto& b : buckets)
+        {
+            for (uint32_t item : b)
+                bucketOf[item] = ABSENT;
+            b.clear();
+        }
+        last = 0;
+        count = 0;
+    }
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+    bool contains(uint32_t item) const { return bucketOf[item] != ABSENT; }
+    int64_t key(uint32_t item) const { return keys[item]; }
+    // Minimum item; moves items between buckets, hence non-const
+    uint32_t top()
+    {
+        settle();
+        return buckets[0].back();
+    }
+    int64_t topKey()
+    {
+        settle();
+        return last;
+    }
+
+    void push(uint32_t item, int64_t k)
+    {
+        keys[item] = k;
+        place(item);
+        ++count;
+    }
+    void decrease(uint32_t item, int64_t k)
+    {
+        unplace(item);
+        keys[item] = k;
+        place(item);
+    }
+    void pop()
+    {
+        settle();
+        uint32_t item = buckets[0].back();
+        buckets[0].pop_back();
+        bucketOf[item] = ABSENT;
+        --count;
+    }
+
+private:
+    int bucketFor(int64_t k) const
+    {
+        uint64_t diff = static_cast<uint64_t>(k) ^ static_cast<uint64_t>(last);
+        return diff == 0 ? 0 : 64 - __builtin_clzll(diff);
+    }
+    void place(uint32_t item)
+    {
+        int b = bucketFor(keys[item]);
+        bucketOf[item] = static_cast<uint32_t>(b);
+        slot[item] = static_cast<uint32_t>(buckets[b].size());
+        buckets[b].push_back(item);
+    }
+    // Swap-removes an item from its bucket
+    void unplace(uint32_t item)
+    {
+        vector<uint32_t>& b = buckets[bucketOf[item]];
+        uint32_t moved = b.back();
+        b[slot[item]] = moved;
+        slot[moved] = slot[item];
+        b.pop_back();
+    }
+    // Makes bucket 0 non-empty: the minimum of the lowest bucket becomes 'last' and the bucket is redistributed
+    void settle()
+    {
+        if (!buckets[0].empty())
+            return;
+        int b = 1;
+        while (buckets[b].empty())
+            ++b;
+        int64_t minKey = keys[buckets[b][0]];
+        for (uint32_t item : buckets[b])
+            if (keys[item] < minKey)
+                minKey = keys[item];
+        last = minKey;
+        vector<uint32_t> moving;
+        moving.swap(buckets[b]);
+        for (uint32_t item : moving)
+            place(item);
+        moving.clear();
+        if (buckets[b].empty())
+            buckets[b].swap(moving);	// keeps the bucket's capacity for reuse
+    }
+
+    vector<uint32_t> buckets[BUCKETS];
+    vector<uint32_t> bucketOf;	// item -> bucket, ABSENT if not queued
+    vector<uint32_t> slot;	// item -> index in its bucket
+    vector<int64_t> keys;
+    int64_t last = 0;		// last popped (minimum) key
+    size_t count = 0;
+};
+
+#endif // GRAPH_HEAP_HPP
@@ -0,0 +1,125 @@
+#ifndef GRAPH_PARALLEL_HPP
+#define GRAPH_PARALLEL_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Returns the thread count to use for a requested count (0 = one per hardware thread)
+inline unsigned workerCount(unsigned requested)
+{
+    if (requested > 0)
+        return requested;
+    unsigned hw = thread::hardware_concurrency();
+    return hw > 0 ? hw : 1;
+}
+
+// Runs task(i, worker) for i in [0, tasks) on up to 'threads' workers numbered 0 .. workers-1,
+// so a task can use scratch space owned by its worker.
+// Work stealing: each worker starts with a contiguous block of task indices and takes them from
+// the front; a worker that runs dry steals the back half of another worker's remaining block.
+// Neighbouring tasks stay on one worker while the load is even, and long tasks do not leave the
+// other workers idle.
+template <class Task>
+void runStealing(unsigned threads, size_t tasks, Task&& task)
+{
+    size_t workers = min<size_t>(workerCount(threads), tasks);
+    if (workers <= 1)
+    {
+        for (size_t i = 0; i < tasks; ++i)
+            task(i, 0);
+        return;
+    }
+    struct alignas(64) Block {
+        mutex lock;
+        size_t next, end;	// tasks [next, end) not started yet
+    };
+    unique_ptr<Block[]> blocks(new Block[workers]);
+    for (size_t w = 0; w < workers; ++w)
+    {
+        blocks[w].next = tasks * w / workers;
+        blocks[w].end = tasks * (w + 1) / workers;
+    }
+    auto worker = [&](size_t w)
+    {
+        Block& own = blocks[w];
+        while (true)
+        {
+            size_t i = tasks;
+            {
+                lock_guard<mutex> g(own.lock);
+                if (own.next < own.end)
+                    i = own.next++;
+            }
+            if (i < tasks)
+            {
+                task(i, w);
+                continue;
+            }
+            // Own block is empty: steal from the next worker that has work left
+            bool stolen = false;
+            for (size_t k = 1; k < workers && !stolen; ++k)
+            {
+                Block& victim = blocks[(w + k) % workers];
+                size_t from, to;
+                {
+                    lock_guard<mutex> g(victim.lock);
+                    if (victim.next >= victim.end)
+                        continue;
+                    to = victim.end;
+                    from = victim.end - (victim.end - victim.next + 1) / 2;
+                    victim.end = from;
+                }
+                lock_guard<mutex> g(own.lock);
+                own.next = from;
+                own.end = to;
+                stolen = true;
+            }
+            // Tasks are never added, so once every block is empty the work is done
+            if (!stolen)
+                return;
+        }
+    };
+    vector<thread> pool;
+    for (size_t w = 1; w < workers; ++w)
+        pool.emplace_back(worker, w);
+    worker(0);
+    for (auto& t : pool)
+        t.join();
+}
+
+// Reusable barrier for a fixed group of threads: wait() returns once every thread of the group has
+// called it. The mutex also orders memory, so data written before wait() is visible after it.
+class PhaseBarrier
+{
+public:
+    explicit PhaseBarrier(size_t threads) : count(threads) {}
+    void wait()
+    {
+        unique_lock<mutex> lock(m);
+        size_t phase = generation;
+        if (++waiting == count)
+        {
+            waiting = 0;
+            ++generation;
+            cv.notify_all();
+            return;
+        }
+        cv.wait(lock, [&] { return generation != phase; });
+    }
+
+private:
+    mutex m;
+    condition_variable cv;
+    size_t count;
+    size_t waiting = 0;
+    size_t generation = 0;
+};
+
+#endif // GRAPH_PARALLEL_HPP
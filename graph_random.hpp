@@ -0,0 +1,163 @@
+#ifndef GRAPH_RANDOM_HPP
+#define GRAPH_RANDOM_HPP
+
+#include "graph_csr.hpp"
+#include "graph_parallel.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+// Reproducible random graphs.
+//   Xoshiro256  seedable generator; a (seed, stream) pair gives an independent sequence, so threads and
+//               trials each draw from their own stream and results do not depend on scheduling
+//   gnpEdges    G(n, p): every pair of vertices is an edge with probability p. Instead of one draw per
+//               pair, the gap to the next edge is drawn from the geometric distribution
+//               (Batagelj & Brandes), so the cost is O(V + E) rather than O(V^2)
+
+// SplitMix64 step: turns a counter into well mixed 64-bit words
+inline uint64_t splitMix64(uint64_t& state)
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Seed for item 'index' of a run seeded with 'seed' (e.g. the k-th graph of a simulation)
+inline uint64_t mixSeed(uint64_t seed, uint64_t index)
+{
+    uint64_t state = seed ^ (index * 0xD1B54A32D192ED03ULL);
+    return splitMix64(state);
+}
+
+// Xoshiro256: xoshiro256** generator (period 2^256 - 1). The state is seeded through SplitMix64;
+// stream k is the sequence jumped ahead k * 2^128 steps, so streams of one seed never overlap.
+// Meets UniformRandomBitGenerator, so it also works with the <random> distributions.
+class Xoshiro256
+{
+public:
+    typedef uint64_t result_type;
+
+    explicit Xoshiro256(uint64_t seed = 0, uint64_t stream = 0)
+    {
+        for (uint64_t& w : s)
+            w = splitMix64(seed);
+        for (uint64_t k = 0; k < stream; ++k)
+            jump();
+    }
+
+    static constexpr uint64_t min() { return 0; }
+    static constexpr uint64_t max() { return UINT64_MAX; }
+
+    uint64_t operator()()
+    {
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+    // Uniform double in [0, 1) from the top 53 bits
+    double uniform() { return static_cast<double>((*this)() >> 11) * 0x1.0p-53; }
+    // Uniform integer in [0, n), n > 0 (multiply-shift; the bias is below n / 2^32)
+    uint32_t below(uint32_t n) { return static_cast<uint32_t>((((*this)() >> 32) * n) >> 32); }
+    // Advances 2^128 steps
+    void jump()
+    {
+        static const uint64_t poly[4] = {0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL, 0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL};
+        uint64_t t[4] = {0, 0, 0, 0};
+        for (uint64_t p : poly)
+            for (int b = 0; b < 64; ++b)
+            {
+                if (p & (uint64_t(1) << b))
+                    for (int i = 0; i < 4; ++i)
+                        t[i] ^= s[i];
+                (*this)();
+            }
+        for (int i = 0; i < 4; ++i)
+            s[i] = t[i];
+    }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    uint64_t s[4];
+};
+
+// Edges of G(n, p) with weights uniform in [minWeight, maxWeight) (minWeight if the range is empty),
+// each as {smaller, larger} vertex and sorted by larger then smaller vertex, on 'threads' threads
+// (0 = one per hardware thread).
+// The pairs are cut into blocks of rows holding about the same number of pairs, and block b draws from
+// stream b of the seed. The number of blocks follows the expected edge count (one block below 16K
+// edges, at most 64) and not the thread count, so a seed gives the same graph on any number of threads.
+inline vector<WeightedEdge> gnpEdges(uint32_t n, double p, int32_t minWeight, int32_t maxWeight, uint64_t seed, unsigned threads = 1)
+{
+    vector<WeightedEdge> edges;
+    if (n < 2 || !(p > 0))
+        return edges;
+    // Row v holds the pairs (w, v) with w < v, so rows up to r hold r (r - 1) / 2 pairs
+    double expected = min(p, 1.0) * n * (n - 1.0) / 2;
+    size_t blocks = static_cast<size_t>(min(64.0, max(1.0, expected / 16384)));
+    vector<uint32_t> firstRow(blocks + 1);
+    for (size_t b = 0; b <= blocks; ++b)
+        firstRow[b] = static_cast<uint32_t>(llround(n * sqrt(static_cast<double>(b) / blocks)));
+    firstRow[blocks] = n;
+    uint32_t range = maxWeight > minWeight ? static_cast<uint32_t>(maxWeight - minWeight) : 0;
+    double logq = log1p(-min(p, 1.0));
+
+    vector<vector<WeightedEdge> > parts(blocks);
+    runStealing(threads, blocks, [&](size_t b, size_t)
+    {
+        Xoshiro256 rng(seed, b);
+        uint32_t rowEnd = firstRow[b + 1];
+        double pairs = (static_cast<double>(rowEnd) * (rowEnd - 1.0) - static_cast<double>(firstRow[b]) * (firstRow[b] - 1.0)) / 2;
+        vector<WeightedEdge>& out = parts[b];
+        out.reserve(static_cast<size_t>(pairs * min(p, 1.0) * 1.05) + 16);
+        // (v, w) walks the pairs row by row; each step skips the pairs that are not edges
+        uint64_t v = max<uint32_t>(firstRow[b], 1);
+        int64_t w = -1;
+        while (v < rowEnd)
+        {
+            double skip = p < 1 ? floor(log1p(-rng.uniform()) / logq) : 0;
+            if (skip >= static_cast<double>(n) * n)
+                break;		// past the last pair
+            w += 1 + static_cast<int64_t>(skip);
+            while (w >= static_cast<int64_t>(v) && v < rowEnd)
+            {
+                w -= static_cast<int64_t>(v);
+                ++v;
+            }
+            if (v < rowEnd)
+            {
+                int32_t weight = minWeight + static_cast<int32_t>(range > 0 ? rng.below(range) : 0);
+                out.push_back(WeightedEdge{static_cast<uint32_t>(w), static_cast<uint32_t>(v), weight});
+            }
+        }
+    });
+
+    size_t total = 0;
+    for (const auto& part : parts)
+        total += part.size();
+    edges.reserve(total);
+    for (auto& part : parts)
+    {
+        edges.insert(edges.end(), part.begin(), part.end());
+        vector<WeightedEdge>().swap(part);
+    }
+    return edges;
+}
+
+// G(n, p) as an undirected CSR graph
+inline CSRGraph gnpGraph(uint32_t n, double p, int32_t minWeight, int32_t maxWeight, uint64_t seed, unsigned threads = 1)
+{
+    return CSRGraph(n, gnpEdges(n, p, minWeight, maxWeight, seed, threads));
+}
+
+#endif // GRAPH_RANDOM_HPP
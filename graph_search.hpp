@@ -0,0 +1,262 @@
+#ifndef GRAPH_SEARCH_HPP
+#define GRAPH_SEARCH_HPP
+
+#include "graph_csr.hpp"
+#include "graph_heap.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+// Point-to-point shortest paths on a CSRGraph:
+//   dijkstra       expands from s until t is settled
+//   bidirectional  expands from s and, on the reverse graph, from t, always on the side with the
+//                  smaller queue; stops once the two queue minima add up to the best s-t path seen
+//   astar          Dijkstra on keys dist(v) + h(v), where h(v) is a lower bound on dist(v, t)
+//                  (admissible); vertices are reopened if an inconsistent h settles them too early
+// Scratch arrays are stamped with a query number, so a query only touches what it reaches and
+// small searches on large graphs stay small. settled() counts the vertices taken from the queues.
+
+// Heuristic that makes astar() plain Dijkstra
+struct ZeroHeuristic {
+    int64_t operator()(uint32_t) const { return 0; }
+};
+
+// Straight-line distance to a target, times 'scale', from coordinates attached to the vertices.
+// Admissible when every edge is at least scale times as long as the segment between its ends.
+class CoordinateHeuristic
+{
+public:
+    CoordinateHeuristic(const vector<double>& xs, const vector<double>& ys, double scale, uint32_t target)
+        : x(xs), y(ys), k(scale), tx(xs[target]), ty(ys[target]) {}
+    int64_t operator()(uint32_t v) const
+    {
+        return static_cast<int64_t>(k * hypot(x[v] - tx, y[v] - ty));
+    }
+
+private:
+    const vector<double>& x;
+    const vector<double>& y;
+    double k, tx, ty;
+};
+
+class PointToPoint
+{
+public:
+    static constexpr int64_t UNREACHABLE = -1;
+
+    PointToPoint() = default;
+    explicit PointToPoint(const CSRGraph& g) { bind(g); }
+    // Searches g from now on; a directed graph gets its reverse built for bidirectional()
+    void bind(const CSRGraph& g);
+
+    // Length of a shortest s-t path, UNREACHABLE if there is none
+    int64_t dijkstra(uint32_t s, uint32_t t);
+    int64_t bidirectional(uint32_t s, uint32_t t);
+    template <class Heuristic>
+    int64_t astar(uint32_t s, uint32_t t, Heuristic&& h);
+
+    // Length found by the last query
+    int64_t length() const { return found; }
+    // Vertices of the path found by the last query, s first (empty if unreachable)
+    vector<uint32_t> path() const;
+    // Vertices settled by the last query (both sides for bidirectional)
+    size_t settled() const { return numSettled; }
+
+private:
+    // One search direction: labels valid where reached[v] == stamp
+    struct Side {
+        vector<int64_t> dist;
+        vector<uint32_t> pred;
+        vector<uint32_t> reached;
+        DaryHeap<4> heap;
+    };
+    // Starts a query: new stamp, empty queues, the source labelled on each side in use
+    void begin(uint32_t s, uint32_t t, bool bothSides);
+    void prepare(Side& side, uint32_t source);
+    bool reached(const Side& side, uint32_t v) const { return side.reached[v] == stamp; }
+    // Settles the minimum of a side and relaxes its arcs in g, calling onLabel(v) for each vertex
+    // labelled or improved
+    template <class OnLabel>
+    void scan(Side& side, const CSRGraph& g, OnLabel&& onLabel);
+
+    // Graph searched by the backward side
+    const CSRGraph& back() const { return fwd->isUndirected() ? *fwd : reversed; }
+
+    const CSRGraph* fwd = nullptr;
+    CSRGraph reversed;		// reverse of a directed graph
+    Side forward, backward;
+    uint32_t stamp = 0;
+    uint32_t source = 0, target = 0, meet = 0;
+    int64_t found = UNREACHABLE;
+    bool twoSided = false;
+    size_t numSettled = 0;
+};
+
+inline void PointToPoint::bind(const CSRGraph& g)
+{
+    if (fwd == &g)
+        return;
+    fwd = &g;
+    if (!g.isUndirected())
+    {
+        vector<WeightedEdge> edges;
+        edges.reserve(g.arcs());
+        for (uint32_t u = 0; u < g.V(); ++u)
+        {
+            EdgeRange adj = g.neighbors(u);
+            for (size_t e = 0; e < adj.size(); ++e)
+                edges.push_back(WeightedEdge{adj.to[e], u, adj.weight[e]});
+        }
+        reversed.build(g.V(), edges, false);
+    }
+    for (Side* side : {&forward, &backward})
+        if (side->reached.size() != g.V())
+        {
+            side->dist.assign(g.V(), 0);
+            side->pred.assign(g.V(), 0);
+            side->reached.assign(g.V(), 0);
+            side->heap.reset(g.V());
+        }
+}
+
+inline void PointToPoint::begin(uint32_t s, uint32_t t, bool bothSides)
+{
+    if (++stamp == 0)
+    {
+        // Stamps wrapped around: forget every old label
+        fill(forward.reached.begin(), forward.reached.end(), 0);
+        fill(backward.reached.begin(), backward.reached.end(), 0);
+        stamp = 1;
+    }
+    source = s;
+    target = t;
+    twoSided = bothSides;
+    numSettled = 0;
+    found = UNREACHABLE;
+    prepare(forward, s);
+    if (bothSides)
+        prepare(backward, t);
+}
+
+inline void PointToPoint::prepare(Side& side, uint32_t from)
+{
+    side.heap.clear();
+    side.reached[from] = stamp;
+    side.dist[from] = 0;
+    side.pred[from] = from;
+}
+
+template <class OnLabel>
+void PointToPoint::scan(Side& side, const CSRGraph& g, OnLabel&& onLabel)
+{
+    uint32_t u = side.heap.top();
+    side.heap.pop();
+    ++numSettled;
+    int64_t du = side.dist[u];
+    EdgeRange adj = g.neighbors(u);
+    for (size_t e = 0; e < adj.size(); ++e)
+    {
+        uint32_t v = adj.to[e];
+        int64_t dv = du + adj.weight[e];
+        if (reached(side, v) && dv >= side.dist[v])
+            continue;
+        side.reached[v] = stamp;
+        side.dist[v] = dv;
+        side.pred[v] = u;
+        onLabel(v);
+    }
+}
+
+inline int64_t PointToPoint::dijkstra(uint32_t s, uint32_t t)
+{
+    return astar(s, t, ZeroHeuristic());
+}
+
+template <class Heuristic>
+int64_t PointToPoint::astar(uint32_t s, uint32_t t, Heuristic&& h)
+{
+    begin(s, t, false);
+    forward.heap.push(s, h(s));
+    while (!forward.heap.empty())
+    {
+        if (forward.heap.top() == t)
+        {
+            found = forward.dist[t];
+            ++numSettled;
+            break;
+        }
+        // A vertex settled too early (inconsistent h) is pushed again when a shorter path turns up
+        scan(forward, *fwd, [&](uint32_t v)
+        {
+            int64_t key = forward.dist[v] + h(v);
+            if (forward.heap.contains(v))
+                forward.heap.decrease(v, key);
+            else
+                forward.heap.push(v, key);
+        });
+    }
+    return found;
+}
+
+inline int64_t PointToPoint::bidirectional(uint32_t s, uint32_t t)
+{
+    begin(s, t, true);
+    forward.heap.push(s, 0);
+    backward.heap.push(t, 0);
+    if (s == t)
+    {
+        found = 0;
+        meet = s;
+        return found;
+    }
+    // best = shortest s-t path through a vertex labelled from both sides so far
+    int64_t best = INT64_MAX;
+    auto label = [&](Side& side, const Side& other, uint32_t v)
+    {
+        if (side.heap.contains(v))
+            side.heap.decrease(v, side.dist[v]);
+        else
+            side.heap.push(v, side.dist[v]);
+        if (reached(other, v) && side.dist[v] + other.dist[v] < best)
+        {
+            best = side.dist[v] + other.dist[v];
+            meet = v;
+        }
+    };
+    // Any path shorter than best would need a vertex below both queue minima
+    while (!forward.heap.empty() && !backward.heap.empty() && forward.heap.topKey() + backward.heap.topKey() < best)
+    {
+        if (forward.heap.size() <= backward.heap.size())
+            scan(forward, *fwd, [&](uint32_t v) { label(forward, backward, v); });
+        else
+            scan(backward, back(), [&](uint32_t v) { label(backward, forward, v); });
+    }
+    if (best != INT64_MAX)
+        found = best;
+    return found;
+}
+
+inline vector<uint32_t> PointToPoint::path() const
+{
+    vector<uint32_t> out;
+    if (found == UNREACHABLE)
+        return out;
+    uint32_t end = twoSided ? meet : target;
+    for (uint32_t x = end; x != source; x = forward.pred[x])
+        out.push_back(x);
+    out.push_back(source);
+    reverse(out.begin(), out.end());
+    if (twoSided)
+        for (uint32_t x = meet; x != target;)
+        {
+            x = backward.pred[x];
+            out.push_back(x);
+        }
+    return out;
+}
+
+#endif // GRAPH_SEARCH_HPP
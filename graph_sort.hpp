@@ -0,0 +1,229 @@
+#ifndef GRAPH_SORT_HPP
+#define GRAPH_SORT_HPP
+
+#include "graph_parallel.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+using namespace std;
+
+// Sorting records by one numeric field: the field is turned into an unsigned key and (key, index)
+// pairs are sorted instead of the records, which are permuted once afterwards.
+//   sortableKey  float / double to an unsigned integer of the same size and the same order
+//   radixSort    parallel LSD radix sort, 11 bits per pass. Each pass counts the digits per block of pairs
+//                and scatters every block to its own offsets; passes in which all keys share the digit
+//                are skipped, so keys from a narrow range take fewer passes
+//   sampleSort   parallel sample sort: splitters taken from a sorted sample cut the pairs into buckets,
+//                which are filled in parallel and then sorted in parallel
+// Both order pairs by (key, index), i.e. they are stable, and give the same result on any number of threads.
+
+enum class KeySort { Std, Radix, Sample };
+
+// Non-negative values get the sign bit set, negative ones have every bit flipped, so the unsigned
+// order of the keys is the numeric order of the values. -0 maps like +0 (they compare equal); NaN must
+// not occur.
+inline uint64_t sortableKey(double x)
+{
+    uint64_t bits = 0;
+    if (x != 0)
+        memcpy(&bits, &x, sizeof(bits));
+    return bits >> 63 ? ~bits : bits | (uint64_t(1) << 63);
+}
+
+inline uint32_t sortableKey(float x)
+{
+    uint32_t bits = 0;
+    if (x != 0)
+        memcpy(&bits, &x, sizeof(bits));
+    return bits >> 31 ? ~bits : bits | (uint32_t(1) << 31);
+}
+
+// Blocks of at least 64K pairs, at most one per thread
+inline size_t sortBlocks(unsigned threads, size_t n)
+{
+    return max<size_t>(1, min<size_t>(workerCount(threads), n >> 16));
+}
+
+// Sorts keys[i] and index[i] together by (key, index) on 'threads' threads (0 = one per hardware thread);
+// index must be ascending where keys are equal, as it is when it starts out as 0, 1, 2 ..
+template <class Key>
+void radixSort(vector<Key>& keys, vector<uint32_t>& index, unsigned threads)
+{
+    const int BITS = 11;	// 2048 counters per block stay in the L1 cache
+    const size_t RADIX = size_t(1) << BITS;
+    const size_t PASSES = (8 * sizeof(Key) + BITS - 1) / BITS;
+    size_t n = keys.size();
+    size_t blocks = sortBlocks(threads, n);
+    auto first = [n, blocks](size_t b) { return n * b / blocks; };
+    auto digit = [](Key k, int shift) { return static_cast<size_t>((k >> shift) & (RADIX - 1)); };
+
+    // Digit counts of every pass over all keys, to find the passes that would not move anything
+    vector<size_t> total(blocks * PASSES * RADIX, 0);
+    runStealing(threads, blocks, [&](size_t b, size_t)
+    {
+        size_t* count = &total[b * PASSES * RADIX];
+        const Key* key = keys.data();
+        for (size_t i = first(b); i < first(b + 1); ++i)
+            for (size_t p = 0; p < PASSES; ++p)
+                ++count[p * RADIX + digit(key[i], static_cast<int>(BITS * p))];
+    });
+    for (size_t b = 1; b < blocks; ++b)
+        for (size_t d = 0; d < PASSES * RADIX; ++d)
+            total[d] += total[b * PASSES * RADIX + d];
+
+    vector<Key> keysOut(n);
+    vector<uint32_t> indexOut(n);
+    vector<size_t> offset(blocks * RADIX);
+    for (size_t p = 0; p < PASSES; ++p)
+    {
+        int shift = static_cast<int>(BITS * p);
+        if (n == 0 || total[p * RADIX + digit(keys[0], shift)] == n)
+            continue;
+        // Block b of digit d goes after all smaller digits and after blocks 0 .. b-1 of digit d, which keeps
+        // the pass stable. With one block the counts taken above are the counts of the block.
+        if (blocks == 1)
+            copy(&total[p * RADIX], &total[p * RADIX] + RADIX, offset.begin());
+        else
+            runStealing(threads, blocks, [&](size_t b, size_t)
+            {
+                size_t* count = &offset[b * RADIX];
+                const Key* key = keys.data();
+                fill(count, count + RADIX, 0);
+                for (size_t i = first(b); i < first(b + 1); ++i)
+                    ++count[digit(key[i], shift)];
+            });
+        size_t sum = 0;
+        for (size_t d = 0; d < RADIX; ++d)
+            for (size_t b = 0; b < blocks; ++b)
+            {
+                size_t c = offset[b * RADIX + d];
+                offset[b * RADIX + d] = sum;
+                sum += c;
+            }
+        runStealing(threads, blocks, [&](size_t b, size_t)
+        {
+            size_t* next = &offset[b * RADIX];
+            const Key* key = keys.data();
+            const uint32_t* from = index.data();
+            Key* keyTo = keysOut.data();
+            uint32_t* indexTo = indexOut.data();
+            for (size_t i = first(b); i < first(b + 1); ++i)
+            {
+                Key k = key[i];
+                size_t slot = next[digit(k, shift)]++;
+                keyTo[slot] = k;
+                indexTo[slot] = from[i];
+            }
+        });
+        keys.swap(keysOut);
+        index.swap(indexOut);
+    }
+}
+
+// Same contract as radixSort()
+template <class Key>
+void sampleSort(vector<Key>& keys, vector<uint32_t>& index, unsigned threads)
+{
+    struct Item {
+        Key key;
+        uint32_t index;
+        bool operator<(const Item& o) const { return key < o.key || (key == o.key && index < o.index); }
+    };
+    size_t n = keys.size();
+    size_t blocks = sortBlocks(threads, n);
+    // A few buckets per block so that uneven buckets still balance out
+    size_t buckets = blocks == 1 ? 1 : blocks * 4;
+
+    // Splitters from an evenly spaced sample, 32 sample items per bucket
+    vector<Item> splitters;
+    if (buckets > 1)
+    {
+        size_t samples = min(n, buckets * 32);
+        vector<Item> sample(samples);
+        for (size_t s = 0; s < samples; ++s)
+        {
+            size_t i = (2 * s + 1) * n / (2 * samples);
+            sample[s] = Item{keys[i], index[i]};
+        }
+        sort(sample.begin(), sample.end());
+        for (size_t k = 1; k < buckets; ++k)
+            splitters.push_back(sample[k * samples / buckets]);
+    }
+
+    // Bucket of every pair, counted per block; bucket k of block b goes after blocks 0 .. b-1 of bucket k
+    auto first = [n, blocks](size_t b) { return n * b / blocks; };
+    vector<uint16_t> bucketOf(n);
+    vector<size_t> offset(blocks * buckets, 0);
+    runStealing(threads, blocks, [&](size_t b, size_t)
+    {
+        size_t* count = &offset[b * buckets];
+        for (size_t i = first(b); i < first(b + 1); ++i)
+        {
+            size_t k = static_cast<size_t>(upper_bound(splitters.begin(), splitters.end(), Item{keys[i], index[i]}) - splitters.begin());
+            bucketOf[i] = static_cast<uint16_t>(k);
+            ++count[k];
+        }
+    });
+    vector<size_t> bucketBegin(buckets + 1, 0);
+    size_t sum = 0;
+    for (size_t k = 0; k < buckets; ++k)
+    {
+        bucketBegin[k] = sum;
+        for (size_t b = 0; b < blocks; ++b)
+        {
+            size_t c = offset[b * buckets + k];
+            offset[b * buckets + k] = sum;
+            sum += c;
+        }
+    }
+    bucketBegin[buckets] = n;
+    vector<Item> items(n);
+    runStealing(threads, blocks, [&](size_t b, size_t)
+    {
+        size_t* next = &offset[b * buckets];
+        for (size_t i = first(b); i < first(b + 1); ++i)
+            items[next[bucketOf[i]]++] = Item{keys[i], index[i]};
+    });
+    vector<uint16_t>().swap(bucketOf);
+
+    runStealing(threads, buckets, [&](size_t k, size_t)
+    {
+        sort(items.begin() + static_cast<ptrdiff_t>(bucketBegin[k]), items.begin() + static_cast<ptrdiff_t>(bucketBegin[k + 1]));
+        for (size_t i = bucketBegin[k]; i < bucketBegin[k + 1]; ++i)
+        {
+            keys[i] = items[i].key;
+            index[i] = items[i].index;
+        }
+    });
+}
+
+// Positions 0 .. n-1 in ascending order of value(i) (a float or double), equal values in position order
+template <class Value>
+vector<uint32_t> sortedOrder(size_t n, Value&& value, KeySort method, unsigned threads)
+{
+    vector<uint32_t> index(n);
+    iota(index.begin(), index.end(), 0);
+    if (method == KeySort::Std)
+    {
+        stable_sort(index.begin(), index.end(), [&value](uint32_t a, uint32_t b) { return value(a) < value(b); });
+        return index;
+    }
+    vector<decltype(sortableKey(value(0)))> keys(n);
+    size_t blocks = sortBlocks(threads, n);
+    runStealing(threads, blocks, [&](size_t b, size_t)
+    {
+        for (size_t i = n * b / blocks; i < n * (b + 1) / blocks; ++i)
+            keys[i] = sortableKey(value(i));
+    });
+    if (method == KeySort::Radix)
+        radixSort(keys, index, threads);
+    else
+        sampleSort(keys, index, threads);
+    return index;
+}
+
+#endif // GRAPH_SORT_HPP
@@ -0,0 +1,61 @@
+#ifndef GRAPH_STATS_HPP
+#define GRAPH_STATS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+using namespace std;
+
+// RunningStats: count, mean, variance, minimum and maximum of a stream of values in O(1) memory.
+// Welford's update keeps the mean and the sum of squared deviations from it (m2), which stays accurate
+// where sum and sum-of-squares formulas cancel. merge() adds another accumulator (Chan et al.), so parts
+// of a stream can be summed up separately and combined.
+class RunningStats
+{
+public:
+    void add(double x)
+    {
+        ++n;
+        double delta = x - mu;
+        mu += delta / static_cast<double>(n);
+        m2 += delta * (x - mu);
+        lo = std::min(lo, x);
+        hi = std::max(hi, x);
+    }
+    void merge(const RunningStats& other)
+    {
+        if (other.n == 0)
+            return;
+        if (n == 0)
+        {
+            *this = other;
+            return;
+        }
+        double total = static_cast<double>(n + other.n);
+        double delta = other.mu - mu;
+        mu += delta * static_cast<double>(other.n) / total;
+        m2 += other.m2 + delta * delta * static_cast<double>(n) * static_cast<double>(other.n) / total;
+        n += other.n;
+        lo = std::min(lo, other.lo);
+        hi = std::max(hi, other.hi);
+    }
+
+    size_t count() const { return n; }
+    double mean() const { return n > 0 ? mu : 0; }
+    // Sample variance (0 for fewer than two values)
+    double variance() const { return n > 1 ? m2 / static_cast<double>(n - 1) : 0; }
+    double stddev() const { return sqrt(variance()); }
+    double minimum() const { return n > 0 ? lo : 0; }
+    double maximum() const { return n > 0 ? hi : 0; }
+
+private:
+    size_t n = 0;
+    double mu = 0;
+    double m2 = 0;
+    double lo = numeric_limits<double>::infinity();
+    double hi = -numeric_limits<double>::infinity();
+};
+
+#endif // GRAPH_STATS_HPP
@@ -0,0 +1,124 @@
+#ifndef GRAPH_SYMBOLS_HPP
+#define GRAPH_SYMBOLS_HPP
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// SymbolTable: optional 1-to-1 mapping between vertex names and vertex numbers 0 .. V-1.
+// Graphs and shortest-path code work on numbers only; names are translated once when a graph is
+// read and when results are printed. Lookups hash through string_views into 'owned', so looking
+// up or interning a known name does not allocate. Strings of names that were replaced are reused
+// for later names, so renaming vertices over and over does not grow the storage.
+class SymbolTable
+{
+public:
+    static constexpr int NONE = -1;
+
+    SymbolTable() = default;
+    SymbolTable(const SymbolTable& other) { *this = other; }
+    SymbolTable& operator=(const SymbolTable& other);
+    SymbolTable(SymbolTable&&) = default;
+    SymbolTable& operator=(SymbolTable&&) = default;
+
+    // Number of the vertex called name; a new name gets the next free number
+    int intern(string_view name);
+    // Number of the vertex called name, NONE if there is none
+    int find(string_view name) const
+    {
+        auto it = numbers.find(name);
+        return it == numbers.end() ? NONE : it->second;
+    }
+    // Names vertex v, dropping its previous name; a name held by another vertex moves to v
+    void assign(int v, string_view name);
+    // Name of vertex v ("" if it has none)
+    const string& name(int v) const
+    {
+        static const string unnamed;
+        size_t i = static_cast<size_t>(v);
+        return v >= 0 && i < names.size() && names[i] != nullptr ? *names[i] : unnamed;
+    }
+    bool contains(string_view name) const { return numbers.count(name) != 0; }
+    // One past the highest named vertex
+    int size() const { return static_cast<int>(names.size()); }
+    bool empty() const { return numbers.empty(); }
+
+private:
+    unordered_map<string_view, int> numbers;
+    deque<string> owned;		// stable storage for the keys of 'numbers'
+    vector<string*> spare;		// entries of 'owned' no vertex uses any more
+    vector<string*> names;		// vertex -> its entry in 'owned', nullptr if unnamed
+};
+
+inline SymbolTable& SymbolTable::operator=(const SymbolTable& other)
+{
+    if (this == &other)
+        return *this;
+    numbers.clear();
+    owned.clear();
+    spare.clear();
+    names.assign(other.names.size(), nullptr);
+    for (size_t v = 0; v < other.names.size(); ++v)
+        if (other.names[v] != nullptr)
+            assign(static_cast<int>(v), *other.names[v]);
+    return *this;
+}
+
+inline int SymbolTable::intern(string_view name)
+{
+    auto it = numbers.find(name);
+    if (it != numbers.end())
+        return it->second;
+    int v = size();
+    assign(v, name);
+    return v;
+}
+
+inline void SymbolTable::assign(int v, string_view name)
+{
+    size_t i = static_cast<size_t>(v);
+    if (v >= size())
+        names.resize(i + 1, nullptr);
+    string* freed = nullptr;
+    if (names[i] != nullptr)
+    {
+        if (*names[i] == name)
+            return;
+        numbers.erase(*names[i]);
+        freed = names[i];
+        names[i] = nullptr;
+    }
+    auto it = numbers.find(name);
+    if (it != numbers.end())
+    {
+        // Name moves from another vertex: reuse its storage
+        size_t from = static_cast<size_t>(it->second);
+        names[i] = names[from];
+        names[from] = nullptr;
+        it->second = v;
+        if (freed != nullptr)
+            spare.push_back(freed);
+        return;
+    }
+    string* slot = freed;
+    if (slot == nullptr && !spare.empty())
+    {
+        slot = spare.back();
+        spare.pop_back();
+    }
+    if (slot == nullptr)
+    {
+        owned.emplace_back();
+        slot = &owned.back();
+    }
+    slot->assign(name.data(), name.size());
+    names[i] = slot;
+    numbers.emplace(*slot, v);
+}
+
+#endif // GRAPH_SYMBOLS_HPP
@@ -1,8 +1,9 @@
 // Kruskal's MST Algorithm
 //  The edges are sorted according to their weights.
+//  Only the weights are sorted, as radix keys with the edge positions (graph_sort.hpp); the edges are then moved into that order.
 //  The edge with least cost is added to the MST if it does not create a cycle.
 //  Each vertex is initially in the set of its own.
-//  Thus, using a parent[] array (for each vertex that is a parent of its own) for e.g. parent[i]=i.
+//  The sets are kept in a disjoint-set union (graph_dsu.hpp): union by size with path halving.
 //  The least weighted edges are added one at a time.
 //  If both end of the edges lie in the same set, then a cycle is formed and that edge is rejected. Otherwise, the edge is selected.
 //  When an edge is added to the MST, all parameters are checked before adding.
@@ -11,6 +12,16 @@
 #include<fstream>
 #include<vector>
 #include<algorithm>
+#include<chrono>
+#include<cmath>
+#include<cstring>
+#include<iomanip>
+#include<string>
+
+#include "graph_dsu.hpp"
+#include "graph_edgelist.hpp"
+#include "graph_random.hpp"
+#include "graph_sort.hpp"
 
 using namespace std;
 
@@ -29,17 +40,15 @@ public:
     //V : vertices and E : edges
     int V, E;
 
-    //The parent[] array : To store the value of the root vertex for each vertex
-    vector<int> parent;
+    //The sets of vertices joined so far (vertices 0..V, so numbering may start at 0 or 1)
+    DisjointSets sets;
 
     explicit Graph(int vertices)
     {
         V=vertices;
-        parent.resize(V+1);
         E=0;
-        //initially, the parent of a vertex is the vertex indeed!
-        for(int i=0;i<=V;++i)
-            parent[i]=i;
+        //initially, every vertex is a set of its own
+        sets.reset(static_cast<uint32_t>(V+1));
     }
 
     //Inserts all the edges to the graph constructor (can be added to a user-defined class easily)
@@ -49,42 +58,93 @@ public:
         E++;    //increment number of edges
     }
 
-    //Returns the parent vertex of a node
-    int findSet(int x)
+    //Inserts all the edges of an edge list
+    void insertEdges(const EdgeList& edges)
     {
-        if(x!=parent[x])
-            parent[x]=findSet(parent[x]);
-
-        return parent[x];
+        graph.reserve(graph.size()+edges.size());
+        for(size_t i=0;i<edges.size();++i)
+            insertEdge(static_cast<int>(edges.from[i]), static_cast<int>(edges.to[i]), edges.weight[i]);
     }
 
-    //MST algorithm : Kruskal's algorithm
-    void kruskal()
+    //Returns the root vertex of the set of a node
+    int findSet(int x)
     {
-        int i, parentu, parentv, MSTsize;
+        return static_cast<int>(sets.find(static_cast<uint32_t>(x)));
+    }
 
-        totalCost=0;
+    //Sorts the edges by weight, equal weights by their vertices (the order sort() gives the pairs)
+    //KeySort::Std sorts the records themselves; Radix and Sample sort the weights as keys with the positions of
+    //their edges, on 'threads' threads (0 = all hardware threads), then move the edges into that order
+    void sortEdges(KeySort method, unsigned threads)
+    {
+        if(method==KeySort::Std)
+        {
+            sort(graph.begin(),graph.end());
+            return;
+        }
+        size_t m=graph.size();
+        size_t blocks=sortBlocks(threads, m);
+        vector<uint32_t> order=sortedOrder(m, [this](size_t i) { return graph[i].first; }, method, threads);
 
-        //Sorts vertices according to weight
-        sort(graph.begin(),graph.end());
+        vector< pair < double, edge > > sorted(m);
+        runStealing(threads, blocks, [&](size_t b, size_t)
+        {
+            for(size_t i=m*b/blocks; i<m*(b+1)/blocks; ++i)
+                sorted[i]=graph[order[i]];
+        });
+        graph.swap(sorted);
 
-        //Processes all the edges
-        for(i=0; i<E;++i)
+        //Runs of equal weights are put in vertex order. Every block takes the runs that start in it: the
+        //first run start of each block is found before any run is sorted, so no block reads another's run
+        vector<size_t> start(blocks+1, m);
+        runStealing(threads, blocks, [&](size_t b, size_t)
         {
-            //Finds parent of each vertex
-            parentu=findSet(graph[i].second.first);
-            parentv=findSet(graph[i].second.second);
+            size_t i=m*b/blocks, end=m*(b+1)/blocks;
+            while(i>0 && i<end && graph[i].first==graph[i-1].first)
+                ++i;
+            start[b]=i<end ? i : m;
+        });
+        for(size_t b=blocks; b-->0;)
+            start[b]=min(start[b], start[b+1]);
+        runStealing(threads, blocks, [&](size_t b, size_t)
+        {
+            for(size_t i=start[b], j; i<start[b+1]; i=j)
+            {
+                for(j=i+1; j<start[b+1] && graph[j].first==graph[i].first; ++j)
+                    ;
+                if(j-i>1)
+                    sort(graph.begin()+static_cast<ptrdiff_t>(i), graph.begin()+static_cast<ptrdiff_t>(j));
+            }
+        });
+    }
+
+    //Processes the sorted edges: keeps each edge that joins two sets (fills MST and totalCost)
+    void selectEdges()
+    {
+        totalCost=0;
+        MST.clear();
+        sets.reset(static_cast<uint32_t>(V+1));
 
-            //Checks if they are part of the same set or not
-            if(parentu!=parentv)
+        for(size_t i=0; i<graph.size();++i)
+        {
+            //Joins the sets of both vertices unless they are part of the same set already
+            if(sets.unite(static_cast<uint32_t>(graph[i].second.first), static_cast<uint32_t>(graph[i].second.second)))
             {
                 MST.push_back(graph[i]);
                 totalCost+=graph[i].first;
-
-                //Parent of one vertex is made equal to the parent of the other vertex
-                parent[parentu]=parent[parentv];
             }
         }
+    }
+
+    //MST algorithm : Kruskal's algorithm
+    void kruskal(KeySort method=KeySort::Radix, unsigned threads=0)
+    {
+        int i, MSTsize;
+
+        //Sorts edges according to weight
+        sortEdges(method, threads);
+
+        selectEdges();
 
         MSTsize=MST.size();
 
@@ -100,27 +160,136 @@ public:
     }
 };
 
-int main()
+//MST of m random edges (vertices 1..m/4, weights 0.000 to 999.999 so that some are equal): sort() on the
+//records against the radix and sample sorts on 1, 2, 4 .. maxThreads threads. Each row shows the time to sort
+//the edges and the time of the whole MST (sorting and unions); the MST checksum must be the same in every row.
+static void benchSort(size_t m, unsigned maxThreads)
 {
-    ifstream fin;
-    fin.open("input.txt");                   //Opens a file name: input.txt
+    auto seconds=[](chrono::steady_clock::time_point t0)
+    {
+        return chrono::duration<double>(chrono::steady_clock::now()-t0).count();
+    };
+    int V=static_cast<int>(max<size_t>(2, m/4));
+    Xoshiro256 rng(1);
+    vector< pair < double, edge > > edges(m);
+    for(size_t i=0;i<m;++i)
+    {
+        double w=floor(rng.uniform()*1e6)/1000;
+        int u=1+static_cast<int>(rng.below(static_cast<uint32_t>(V)));
+        int v=1+static_cast<int>(rng.below(static_cast<uint32_t>(V)));
+        edges[i]=make_pair(w, edge(u, v));
+    }
 
-    int V = 0,E=0,u = 0,v = 0;              //Initializing values
-    double w = 0;
+    cout<<"Kruskal: "<<V<<" vertices, "<<m<<" edges"<<endl;
+    cout<<setw(10)<<"sort"<<setw(10)<<"threads"<<setw(12)<<"sort s"<<setw(12)<<"MST s"<<setw(22)<<"checksum"<<endl;
+    auto run=[&](const char* name, KeySort method, unsigned threads)
+    {
+        Graph G(V);
+        G.graph=edges;
+        G.E=static_cast<int>(m);
+        auto t0=chrono::steady_clock::now();
+        G.sortEdges(method, threads);
+        double sortSec=seconds(t0);
+        G.selectEdges();
+        double total=seconds(t0);
+        unsigned long long sum=0;
+        for(const auto& e : G.MST)
+            sum=sum*31+static_cast<unsigned long long>(e.second.first)*7919ULL+static_cast<unsigned long long>(e.second.second)*104729ULL;
+        cout<<setw(10)<<name<<setw(10)<<threads<<setw(12)<<fixed<<setprecision(4)<<sortSec<<setw(12)<<total<<setw(22)<<sum<<endl;
+    };
+    run("std", KeySort::Std, 1);
+    for(unsigned t=1; t<=maxThreads; t=t<maxThreads && t*2>maxThreads ? maxThreads : t*2)
+        run("radix", KeySort::Radix, t);
+    for(unsigned t=1; t<=maxThreads; t=t<maxThreads && t*2>maxThreads ? maxThreads : t*2)
+        run("sample", KeySort::Sample, t);
+}
+
+//Prints command line help
+static void usage(const char* prog)
+{
+    cerr<<"usage: "<<prog<<" [--cache] [--threads=N] [--sort=radix|sample|std] [input_file]"<<endl
+        <<"       "<<prog<<" --bench[=edges] [--threads=N]"<<endl
+        <<"  input_file      vertex count on the first line, then one \"u v w\" edge per line (default input.txt)"<<endl
+        <<"  --cache         read the edges from <input_file>.edgebin, (re)writing it when missing or stale"<<endl
+        <<"  --threads=N     parse and sort on N threads (0 = all hardware threads, the default)"<<endl
+        <<"  --sort=method   sort the weights as radix keys (default) or by sample sort, or sort() the edges"<<endl
+        <<"  --bench[=edges] time the MST of random edges (default 10000000) with each sort on up to N threads"<<endl;
+}
+
+int main(int argc, const char* argv[])
+{
+    bool useCache=false;
+    unsigned threads=0;
+    KeySort method=KeySort::Radix;
+    size_t benchEdges=0;
+    string input="input.txt";              //Default input file name: input.txt
+
+    int arg=1;
+    for(; arg<argc && strncmp(argv[arg], "--", 2)==0; ++arg)
+    {
+        string opt=argv[arg];
+        if(opt=="--cache")
+            useCache=true;
+        else if(opt.compare(0, 10, "--threads=")==0)
+            threads=static_cast<unsigned>(stoul(opt.substr(10)));
+        else if(opt=="--sort=radix" || opt=="--sort=sample" || opt=="--sort=std")
+            method=opt=="--sort=radix" ? KeySort::Radix : opt=="--sort=sample" ? KeySort::Sample : KeySort::Std;
+        else if(opt=="--bench")
+            benchEdges=10000000;
+        else if(opt.compare(0, 8, "--bench=")==0)
+            benchEdges=static_cast<size_t>(stoull(opt.substr(8)));
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if(argc-arg>1)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+    if(arg<argc)
+        input=argv[arg];
 
-    fin>>V;
+    if(benchEdges>0)
+    {
+        benchSort(benchEdges, workerCount(threads));
+        return 0;
+    }
 
-    Graph G(V);
+    //The edges are read from the binary cache if it is valid, otherwise parsed from the text file
+    EdgeList edges;
+    string error;
+    if(!(useCache && readEdgeCache(input, edges)))
+    {
+        if(!readEdgeList(input, threads, edges, error))
+        {
+            cerr<<input<<": "<<error<<endl;
+            return 1;
+        }
+        if(useCache && !writeEdgeCache(input, edges))
+            cerr<<"cannot write cache file: "<<edgeCacheFileName(input)<<endl;
+    }
 
-    while(!fin.eof())
+    //Vertices are numbered from 0 or 1 up to V
+    if(edges.vertices>static_cast<uint32_t>(INT32_MAX-1))
     {
-        fin>>u>>v>>w;
-        E++;
-        G.insertEdge(u,v,w);
+        cerr<<input<<": too many vertices"<<endl;
+        return 1;
     }
+    for(size_t i=0;i<edges.size();++i)
+        if(edges.from[i]>edges.vertices || edges.to[i]>edges.vertices)
+        {
+            cerr<<input<<": edge "<<i+1<<" has a vertex above "<<edges.vertices<<endl;
+            return 1;
+        }
+
+    Graph G(static_cast<int>(edges.vertices));
+    G.insertEdges(edges);
+    edges=EdgeList();                       //The edge list is no longer needed
 
-    G.kruskal();
+    G.kruskal(method, threads);
 
     return 0;
 }
-
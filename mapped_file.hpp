@@ -0,0 +1,106 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+// MappedFile: read-only memory mapping of a whole file (unmapped on destruction)
+// Behaves like an ifstream: check is_open() after construction.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    explicit MappedFile(const string& filename) { open(filename); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept { swap(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept { close(); swap(other); return *this; }
+    ~MappedFile() { close(); }
+
+    bool open(const string& filename);
+    void close();
+    bool is_open() const { return opened; }
+    const char* data() const { return ptr; }
+    size_t size() const { return len; }
+    string_view view() const { return string_view(ptr, len); }
+
+private:
+    void swap(MappedFile& other) noexcept
+    {
+        std::swap(ptr, other.ptr);
+        std::swap(len, other.len);
+        std::swap(opened, other.opened);
+    }
+
+    const char* ptr = nullptr;
+    size_t len = 0;
+    bool opened = false;
+};
+
+// Maps the file read-only; an empty file is a valid, empty mapping
+inline bool MappedFile::open(const string& filename)
+{
+    close();
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    len = static_cast<size_t>(st.st_size);
+    if (len > 0)
+    {
+        void* p = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED)
+        {
+            ::close(fd);
+            len = 0;
+            return false;
+        }
+        // Readers walk the file front to back
+        madvise(p, len, MADV_SEQUENTIAL);
+        ptr = static_cast<const char*>(p);
+    }
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+    opened = true;
+    return true;
+}
+
+// Releases the mapping
+inline void MappedFile::close()
+{
+    if (ptr != nullptr)
+        munmap(const_cast<char*>(ptr), len);
+    ptr = nullptr;
+    len = 0;
+    opened = false;
+}
+
+// Reads size and modification time of a file; returns false if it cannot be stat'ed
+inline bool fileStamp(const string& filename, uint64_t& size, int64_t& mtime)
+{
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0)
+        return false;
+    size = static_cast<uint64_t>(st.st_size);
+#ifdef __APPLE__
+    mtime = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    return true;
+}
+
+#endif // MAPPED_FILE_HPP
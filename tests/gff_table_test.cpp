@@ -0,0 +1,89 @@
+// Regression tests for the columnar GFF3 table (gff_table.hpp) and its writer
+
+#include "../gff_table.hpp"
+#include "../gff_writer.hpp"
+
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        cerr << "FAILED: " << what << endl;
+        ++failures;
+    }
+}
+
+// StringDict::find() must answer -1 for a string that was never interned, not a code cast to unsigned
+static void unknownKeys()
+{
+    StringDict dict;
+    dict.intern("ID");
+    dict.intern("Parent");
+    check(dict.find("Parent") == 1, "find() returns the code of an interned string");
+    check(dict.find("Name") == -1, "find() returns -1 for an unknown string");
+
+    GFFTable table;
+    GFFView v;
+    check(parseGFFLine("chr1\tsrc\tgene\t100\t200\t.\t+\t.\tID=g1;Name=abc", v), "parse a GFF3 line");
+    table.append(v);
+    check(table.attribute(0, "Name") == "abc", "attribute() finds a known key");
+    check(table.attribute(0, "Note").empty(), "attribute() of an unknown key is empty");
+    check(table.contained("chr1", 1, 1000).size() == 1, "contained() on a known seqid");
+    check(table.contained("chrX", 1, 1000).empty(), "contained() on an unknown seqid is empty");
+}
+
+// Views, entries and tables of one line must write the same attributes: file order, a repeated key once
+static void attributeOrder()
+{
+    const string expected = "chr1\tsrc\tmRNA\t10\t90\t.\t+\t.\tParent=g1;ID=t1;Zeta=1;Name=b\n";
+    GFFView v;
+    check(parseGFFLine("chr1\tsrc\tmRNA\t10\t90\t.\t+\t.\tParent=g1;ID=t1;Name=a;Zeta=1;Name=b;Bad;Empty=", v),
+          "parse a GFF3 line");
+    GFFTable table;
+    table.append(v);
+    GFFTable copy;
+    copy.append(toGFFEntry(v));
+
+    auto line = [](auto&& write)
+    {
+        ostringstream os;
+        {
+            GFFWriter out(os);
+            write(out);
+        }
+        return os.str();
+    };
+    check(line([&](GFFWriter& out) { out.write(v); }) == expected, "a view keeps file order");
+    check(line([&](GFFWriter& out) { out.write(toGFFEntry(v)); }) == expected, "an entry keeps file order");
+    check(line([&](GFFWriter& out) { out.write(table, 0); }) == expected, "a table keeps file order");
+    check(line([&](GFFWriter& out) { out.write(table.entry(0)); }) == expected, "a table entry keeps file order");
+    check(line([&](GFFWriter& out) { out.write(copy, 0); }) == expected, "a table built from an entry keeps file order");
+    ostringstream os;
+    writeEntry(os, toGFFEntry(v));
+    check(os.str() == expected, "writeEntry() keeps file order");
+    check(table.attribute(0, "Name") == "b", "the last duplicate wins");
+
+    // tags changed directly, keeping their count: tagOrder no longer names them, so key order is used
+    GFFEntry edited = toGFFEntry(v);
+    edited.tags.erase("Zeta");
+    edited.tags["Alias"] = "x";
+    ostringstream byKey;
+    writeEntry(byKey, edited);
+    check(byKey.str() == "chr1\tsrc\tmRNA\t10\t90\t.\t+\t.\tAlias=x;ID=t1;Name=b;Parent=g1\n",
+          "an entry edited without setTag() is written in key order");
+}
+
+int main()
+{
+    unknownKeys();
+    attributeOrder();
+    if (failures == 0)
+        cout << "all tests passed" << endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+// Regression tests for the disjoint-set types (graph_dsu.hpp)
+
+#include "../graph_dsu.hpp"
+#include "../graph_parallel.hpp"
+
+#include <iostream>
+#include <random>
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        cerr << "FAILED: " << what << endl;
+        ++failures;
+    }
+}
+
+// Random unions from several workers at once must leave the same partition as uniting the same
+// pairs on one thread, and exactly one unite() per merge may report it
+static void concurrentUnite(uint32_t n, size_t pairs, unsigned threads, uint32_t seed)
+{
+    mt19937 random(seed);
+    uniform_int_distribution<uint32_t> element(0, n - 1);
+    vector<pair<uint32_t, uint32_t> > edges(pairs);
+    for (auto& e : edges)
+        e = make_pair(element(random), element(random));
+
+    ConcurrentDisjointSets shared(n);
+    atomic<uint32_t> merged(0);
+    const size_t CHUNK = 256;
+    runStealing(threads, (edges.size() + CHUNK - 1) / CHUNK, [&](size_t task, size_t)
+    {
+        size_t end = min(edges.size(), (task + 1) * CHUNK);
+        for (size_t k = task * CHUNK; k < end; ++k)
+            if (shared.unite(edges[k].first, edges[k].second))
+                merged.fetch_add(1, memory_order_relaxed);
+    });
+
+    DisjointSets expected(n);
+    for (const auto& e : edges)
+        expected.unite(e.first, e.second);
+
+    // Same partition: the representatives of both map one to one
+    vector<uint32_t> toShared(n, n), toExpected(n, n);
+    uint32_t roots = 0;
+    bool matches = true;
+    for (uint32_t x = 0; x < n; ++x)
+    {
+        uint32_t s = shared.find(x), e = expected.find(x);
+        if (toShared[e] == n && toExpected[s] == n)
+        {
+            toShared[e] = s;
+            toExpected[s] = e;
+        }
+        matches = matches && toShared[e] == s && toExpected[s] == e;
+        if (shared.isRoot(x))
+            ++roots;
+    }
+    check(matches, "concurrent unions give the sequential partition");
+    check(roots == expected.sets(), "one root per set");
+    check(merged.load() == n - expected.sets(), "one successful unite() per merge");
+    check(shared.same(edges[0].first, edges[0].second), "same() on united elements");
+}
+
+int main()
+{
+    concurrentUnite(1000, 600, 4, 1);		// many sets left
+    concurrentUnite(100000, 200000, 8, 2);	// nearly one set, long contended paths
+    concurrentUnite(64, 20000, 8, 3);		// every worker hits the same few roots
+    if (failures == 0)
+        cout << "all tests passed" << endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,157 @@
+// Regression tests for the edge list reader and its binary cache (graph_edgelist.hpp)
+
+#include "../graph_edgelist.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <random>
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        cerr << "FAILED: " << what << endl;
+        ++failures;
+    }
+}
+
+static bool sameEdges(const EdgeList& a, const EdgeList& b)
+{
+    return a.vertices == b.vertices && a.from == b.from && a.to == b.to && a.weight == b.weight;
+}
+
+// Text of 'lines' edge lines of equal length after the vertex count, and the edges it holds
+static string edgeText(size_t lines, EdgeList& edges)
+{
+    mt19937 random(7);
+    edges = EdgeList();
+    edges.vertices = 1000000;
+    string text = "1000000\n";
+    char line[64];
+    for (size_t k = 0; k < lines; ++k)
+    {
+        uint32_t u = random() % 1000000, v = random() % 1000000;
+        double w = static_cast<double>(random() % 100000) / 100;
+        snprintf(line, sizeof(line), "%06u\t%06u %08.2f\n", u, v, w);
+        text += line;
+        edges.from.push_back(u);
+        edges.to.push_back(v);
+        edges.weight.push_back(w);
+    }
+    return text;
+}
+
+// The last line may end without '\n', on one thread or on several
+static void noTrailingNewline()
+{
+    EdgeList edges;
+    string error;
+    check(parseEdgeList("3\n0 1 2.5\n1 2 1", 1, edges, error) && edges.size() == 2 && edges.weight[1] == 1,
+          "last edge without a newline");
+    check(parseEdgeList("3", 1, edges, error) && edges.vertices == 3 && edges.size() == 0, "vertex count without a newline");
+
+    EdgeList expected, parsed;
+    string text = edgeText(200000, expected);
+    text.pop_back();
+    check(parseEdgeList(text, 4, parsed, error) && sameEdges(parsed, expected), "large text without a newline on 4 threads");
+}
+
+// Blank lines (spaces, tabs, "\r") right before and after the cuts between chunks are skipped, and the
+// gaps they leave are closed so the edges keep the file order
+static void blankLinesAtChunkEdges()
+{
+    EdgeList all;
+    string text = edgeText(200000, all);		// about 4.6 MB: 4 threads cut it into 5 chunks
+    size_t head = text.find('\n') + 1, lineSize = text.find('\n', head) + 1 - head;
+    size_t bodySize = text.size() - head, parts = 5;
+    vector<char> blank(all.size(), 0);
+    // Blank lines keep their length, so the cuts stay where they are
+    for (size_t c = 1; c < parts; ++c)
+    {
+        size_t cut = bodySize * c / parts / lineSize;
+        for (size_t k = cut - 3; k <= cut + 3; ++k)
+        {
+            text.replace(head + k * lineSize, lineSize - 1, string(lineSize - 1, k % 2 ? ' ' : '\t'));
+            if (k == cut)
+                text[head + k * lineSize + lineSize - 2] = '\r';
+            blank[k] = 1;
+        }
+    }
+    for (size_t k = 0; k < 3; ++k)
+    {
+        text.replace(head + k * lineSize, lineSize - 1, string(lineSize - 1, ' '));
+        blank[k] = 1;
+    }
+    EdgeList expected;
+    expected.vertices = all.vertices;
+    for (size_t k = 0; k < all.size(); ++k)
+        if (!blank[k])
+        {
+            expected.from.push_back(all.from[k]);
+            expected.to.push_back(all.to[k]);
+            expected.weight.push_back(all.weight[k]);
+        }
+
+    EdgeList one, four;
+    string error;
+    check(parseEdgeList(text, 1, one, error) && sameEdges(one, expected), "blank lines on one thread");
+    check(parseEdgeList(text, 4, four, error) && sameEdges(four, expected), "blank lines at chunk edges on 4 threads");
+}
+
+// A malformed line is reported with its line number in the file, in any chunk
+static void malformedLine()
+{
+    EdgeList edges;
+    string error;
+    check(!parseEdgeList("3\n0 1 1\n\n1 x 2\n", 1, edges, error) && error.rfind("line 4:", 0) == 0 && edges.size() == 0,
+          "malformed line reported as line 4");
+    check(!parseEdgeList("x\n0 1 1\n", 1, edges, error) && error.rfind("line 1:", 0) == 0, "malformed vertex count");
+    check(!parseEdgeList("3\n0 1 1 9\n", 1, edges, error) && error.rfind("line 2:", 0) == 0, "extra field");
+
+    EdgeList expected;
+    string text = edgeText(200000, expected);
+    size_t head = text.find('\n') + 1, lineSize = text.find('\n', head) + 1 - head;
+    size_t bad = 150000;	// in the fourth of five chunks
+    text[head + bad * lineSize + 2] = '-';
+    for (unsigned threads : {1u, 4u})
+        check(!parseEdgeList(text, threads, edges, error) && error.rfind("line " + to_string(bad + 2) + ":", 0) == 0,
+              "malformed line in a later chunk reported with its line number");
+}
+
+// A cache is used until its input changes: touching the input makes it stale
+static void cacheInvalidation()
+{
+    const string file = "graph_edgelist_test.txt";
+    ofstream(file, ios::binary | ios::trunc) << "4\n0 1 1.5\n1 2 2\n2 3 0.25\n";
+    EdgeList edges, cached;
+    string error;
+    check(readEdgeList(file, 1, edges, error) && edges.size() == 3, "read the text file");
+    check(!readEdgeCache(file, cached), "no cache before it is written");
+    check(writeEdgeCache(file, edges), "writeEdgeCache()");
+    check(readEdgeCache(file, cached) && sameEdges(cached, edges), "cache read back");
+
+    filesystem::last_write_time(file, filesystem::last_write_time(file) + chrono::seconds(2));
+    check(!readEdgeCache(file, cached), "touched input invalidates the cache");
+    check(writeEdgeCache(file, edges) && readEdgeCache(file, cached), "rewritten cache is valid again");
+
+    ofstream(file, ios::binary | ios::app) << "3 0 1\n";
+    check(!readEdgeCache(file, cached), "longer input invalidates the cache");
+    remove(file.c_str());
+    remove(edgeCacheFileName(file).c_str());
+}
+
+int main()
+{
+    noTrailingNewline();
+    blankLinesAtChunkEdges();
+    malformedLine();
+    cacheInvalidation();
+    if (failures == 0)
+        cout << "all tests passed" << endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+// Regression tests for ShortestPath ("dijkstras_ algorithm.cpp", built here without its main())
+
+#define DIJKSTRAS_NO_MAIN
+#include "../dijkstras_ algorithm.cpp"
+
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        cerr << "FAILED: " << what << endl;
+        ++failures;
+    }
+}
+
+// A search that stops at its target must not be reused as a complete tree, even when the target was
+// the last node in the queue: its arcs were never relaxed
+static void reuseAfterTargetStop()
+{
+    Graph g(3);
+    g.set_edge_value(0, 1, 1);
+    g.set_edge_value(1, 2, 1);
+    ShortestPath sp(g);
+    check(sp.path_size(0, 1) == 1, "path_size(0, 1) on the path 0-1-2");
+    check(sp.path_size(0, 2) == 2, "path_size(0, 2) after a search stopped at 1");
+    check(sp.tree(0).length(2) == 2, "tree(0) after a search stopped at 1");
+
+    ShortestPath again(g);
+    check(again.path_size(0, 1) == 1, "path_size(0, 1) again");
+    vector<int> p = again.path(0, 2);
+    check(p == vector<int>({0, 1, 2}), "path(0, 2) after a search stopped at 1");
+}
+
+// load_hierarchy() must only accept a file built from this very graph, and reject damaged files
+static void hierarchyFiles()
+{
+    const string file = "shortest_path_test.ch";
+    Graph g(4);
+    g.set_edge_value(0, 1, 2);
+    g.set_edge_value(1, 2, 2);
+    g.set_edge_value(2, 3, 2);
+    g.set_edge_value(0, 3, 9);
+    ShortestPath sp(g);
+    sp.set_mode(HIERARCHY);
+    check(sp.save_hierarchy(file), "save_hierarchy()");
+
+    ShortestPath same(g);
+    same.set_mode(HIERARCHY);
+    check(same.load_hierarchy(file), "load_hierarchy() of the same graph");
+    check(same.path_size(0, 3) == 6, "query on a loaded hierarchy");
+
+    Graph other(4);
+    other.set_edge_value(0, 1, 2);
+    other.set_edge_value(1, 2, 2);
+    other.set_edge_value(2, 3, 2);
+    other.set_edge_value(0, 3, 1);
+    ShortestPath changed(other);
+    changed.set_mode(HIERARCHY);
+    check(!changed.load_hierarchy(file), "load_hierarchy() rejects a graph with other weights");
+    check(changed.path_size(0, 3) == 1, "a rejected file is not used");
+
+    // Damaged copies: truncated, a huge vertex count, an arc to a vertex out of range, a repeated rank
+    ifstream in(file, ios::binary);
+    string bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    in.close();
+    auto rejects = [&](string damaged, const char* what)
+    {
+        ofstream(file, ios::binary | ios::trunc) << damaged;
+        ContractionHierarchy ch;
+        check(!ch.load(file) && ch.V() == 0, what);
+    };
+    rejects(bytes.substr(0, bytes.size() - 1), "load() rejects a truncated file");
+    string huge = bytes;
+    uint32_t vertices = 0x40000000;
+    memcpy(&huge[offsetof(CHFileHeader, vertices)], &vertices, sizeof(vertices));
+    rejects(huge, "load() rejects a vertex count the file cannot hold");
+    size_t arcs = sizeof(CHFileHeader) + 4 * sizeof(uint32_t) + 5 * sizeof(uint32_t);
+    string badArc = bytes;
+    uint32_t to = 7;
+    memcpy(&badArc[arcs + offsetof(CHArc, to)], &to, sizeof(to));
+    rejects(badArc, "load() rejects an arc to a missing vertex");
+    string badRank = bytes;
+    memcpy(&badRank[sizeof(CHFileHeader)], &bytes[sizeof(CHFileHeader) + sizeof(uint32_t)], sizeof(uint32_t));
+    rejects(badRank, "load() rejects ranks that are not a permutation");
+    remove(file.c_str());
+}
+
+// DELTA_STEPPING on a graph with a zero weight: the predecessors must still form a tree
+static void deltaSteppingZeroWeights()
+{
+    Graph g(3);
+    g.set_edge_value(2, 0, 1);
+    g.set_edge_value(2, 1, 1);
+    g.set_edge_value(0, 1, 1);
+    ShortestPath positive(g);
+    positive.set_mode(DELTA_STEPPING);
+    check(positive.path(2, 0) == vector<int>({2, 0}), "delta-stepping path with positive weights");
+    g.set_edge_value(0, 1, 0);
+    ShortestPath sp(g);
+    sp.set_mode(DELTA_STEPPING);
+    vector<int> p = sp.path(2, 0);
+    check(p.size() >= 2 && p.size() <= 3 && p.front() == 2 && p.back() == 0, "path(2, 0) after a zero weight");
+    check(sp.path_size(2, 1) == 1 && sp.tree(2).length(0) == 1, "distances after a zero weight");
+}
+
+// tree() of a tracked source comes from its repaired tree after a weight change
+static void trackedTree()
+{
+    Graph g(5);
+    g.set_edge_value(0, 1, 1);
+    g.set_edge_value(1, 2, 1);
+    g.set_edge_value(2, 3, 1);
+    g.set_edge_value(0, 3, 10);
+    ShortestPath sp(g);
+    sp.track(0);
+    check(sp.tree(0).length(3) == 3, "tree(0) of a tracked source");
+    check(sp.set_edge_value(1, 2, 20), "raise a weight on the tracked tree");
+    ShortestPathTree t = sp.tree(0);
+    check(t.length(3) == 10 && t.path(3) == vector<int>({0, 3}), "tree(0) after the change");
+    check(t.length(2) == 11 && !t.reachable(4), "other nodes of tree(0) after the change");
+}
+
+int main()
+{
+    reuseAfterTargetStop();
+    hierarchyFiles();
+    deltaSteppingZeroWeights();
+    trackedTree();
+    if (failures == 0)
+        cout << "all tests passed" << endl;
+    return failures == 0 ? 0 : 1;
+}